@@ -13,12 +13,15 @@
 #include <string>
 #include <vector>
 #include <array>
+#include <condition_variable>
 #include <cstdarg>
+#include <mutex>
 // nist
 #include <nist_gear/VacuumGripperState.h>
 #include <nist_gear/VacuumGripperControl.h>
 // custom
 #include "../util/util.h"
+#include "../util/registry.h"
 #include "../comp/comp_class.h"
 
 namespace motioncontrol {
@@ -92,12 +95,15 @@ namespace motioncontrol {
          */
         void deactivateGripper();
         /**
-         * @brief Get the pose of the part to be place in empty bin 
-         * 
-         * @param bin_number bin number, value in between 1-8
-         * @return geometry_msgs::Pose Pose in world frame
+         * @brief Wait for the gripper to hold a part
+         *
+         * Wakes with the gripper state message that reports it.
+         *
+         * @param deadline Time after which the wait gives up
+         * @return true A part is attached
+         * @return false Nothing attached by the deadline
          */
-        geometry_msgs::Pose get_part_pose_in_empty_bin(int bin_number);
+        bool waitForAttached(const ros::Time& deadline);
         /**
          * @brief Move the joint linear_arm_actuator_joint only
          *
@@ -128,31 +134,47 @@ namespace motioncontrol {
         /**
          * @brief Move the kitting arm to preset location
          * 
-         * @param location_name Location
+         * @param location_name Location, as named in motioncontrol::Registry::arm_presets
          */
         void goToPresetLocation(std::string location_name);
+        /**
+         * @brief Move the kitting arm to preset location
+         * 
+         * @param preset Location
+         */
+        void goToPresetLocation(ArmPreset preset);
         /**
          * @brief Pick part from conveyor
          * 
+         * Waits at the belt for the next part predicted by BeltTracker and
+         * moves upstream to meet it when it is still far away. A part that
+         * is not attached shortly after its predicted arrival is skipped.
+         * Stops early when no part is predicted within kBeltTimeout.
+         * 
          * @param ebin empty bin number
          * @param int number of parts to be picked
          * @return std::vector<int> 
          */
         std::vector<int> pick_from_conveyor(std::vector<int> ebin, unsigned short int);
+        /**
+         * @brief Reserve the spot of a staging bin a part is flipped on
+         * 
+         * @param type Part type
+         * @param empty_bins Empty bins, tried first
+         * @param bin Filled with the bin of the spot
+         * @return true Spot reserved
+         * @return false No staging bin has room, the part must not be flipped
+         */
+        bool reserveFlipSpot(PartType type, const std::vector<int>& empty_bins, int& bin);
         /**
          * @brief Flips the part(pump)
          * 
          * @param part Product
-         * @param rbin empty bins
+         * @param bin Bin of the spot reserved with reserveFlipSpot
          * @param part_pose_in_frame Pose in world frame 
          * @param agv Agv_id
          */
-        void flippart(Product part, std::vector<int> rbin, geometry_msgs::Pose part_pose_in_frame, std::string agv, bool);
-
-        //--preset locations;
-        start home1_, home2_;
-        agv agv1_, agv2_, agv3_, agv4_;
-        conveyor on_, above_, flip_;
+        void flippart(Product part, int bin, geometry_msgs::Pose part_pose_in_frame, std::string agv, bool);
 
         private:
         std::array<double,3> bin1_origin_ { -1.898, 3.37, 0.751 };
@@ -163,7 +185,6 @@ namespace motioncontrol {
         std::array<double,3> bin6_origin_ { -1.898, -2.56, 0.751 };
         std::array<double,3> bin7_origin_ { -2.651, -2.56, 0.751 };
         std::array<double,3> bin8_origin_ { -2.651, -3.37, 0.751 };
-        int empty_bin_place_count = 0;
         std::vector<double> joint_group_positions_;
         std::vector<double> joint_arm_positions_;
         ros::NodeHandle node_;
@@ -174,6 +195,8 @@ namespace motioncontrol {
         control_msgs::JointTrajectoryControllerState arm_controller_state_;
 
         nist_gear::VacuumGripperState gripper_state_;
+        std::mutex gripper_mutex_;
+        std::condition_variable gripper_changed_;
         // gripper state subscriber
         ros::Subscriber gripper_state_subscriber_;
         // service client
@@ -289,6 +312,16 @@ namespace gantry_motioncontrol {
         void activateGripper();
         void deactivateGripper();
         nist_gear::VacuumGripperState getGripperState();
+        /**
+         * @brief Wait for the gripper to hold a part
+         *
+         * Wakes with the gripper state message that reports it.
+         *
+         * @param deadline Time after which the wait gives up
+         * @return true A part is attached
+         * @return false Nothing attached by the deadline
+         */
+        bool waitForAttached(const ros::Time& deadline);
         //--preset locations;
         start home_, home2_;
         bin at_bin1_,at_bin2_, at_bin3_, at_bin4_, at_bin5_, at_bin6_, at_bin7_, at_bin8_, safe_bins_, at_bins1234_, at_bins5678_;
@@ -318,6 +351,8 @@ namespace gantry_motioncontrol {
         moveit::planning_interface::MoveGroupInterface torso_gantry_group_;
         sensor_msgs::JointState current_joint_states_;
         nist_gear::VacuumGripperState gantry_gripper_state_;
+        std::mutex gripper_mutex_;
+        std::condition_variable gripper_changed_;
         control_msgs::JointTrajectoryControllerState gantry_torso_controller_state_;
         control_msgs::JointTrajectoryControllerState gantry_arm_controller_state_;
 
@@ -0,0 +1,154 @@
+#ifndef BELT_TRACKER_H
+#define BELT_TRACKER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+#include "../util/util.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Position and speed of the parts travelling on the conveyor belt
+     *
+     * The belt moves every part along the world y axis at the same speed,
+     * so a single belt velocity is estimated from the displacement of the
+     * tracked parts between images of logical_camera_belt. A breakbeam
+     * crossing fixes the position of the part at the beam, or starts a
+     * track of unknown type that the camera later identifies; a part is
+     * fixed once per beam, so only rising edges should be passed in.
+     * Observations closer than kMinInterval move the part without
+     * updating the velocity. Between
+     * observations a part is predicted at constant velocity, which gives
+     * the time and place it reaches the pick zone of the kitting arm.
+     *
+     * A track is dropped when it is picked, when the camera misses it
+     * kMissedFrames times in a row while it should be in view, or when it
+     * has not been observed for kCoastTime.
+     */
+    class BeltTracker {
+        public:
+        /// Largest distance between a predicted part and a detection of that part, in meters
+        static constexpr double kGate = 0.15;
+        /// Weight of the latest measurement in the smoothed belt velocity
+        static constexpr double kVelocitySmoothing = 0.3;
+        /// Images without the part, while it should be in view, before it is dropped
+        static constexpr int kMissedFrames = 3;
+        /// Time a part is predicted without being observed, in seconds
+        static constexpr double kCoastTime = 30.0;
+        /// Shortest time between two observations of a part that measures the velocity, in seconds
+        static constexpr double kMinInterval = 0.05;
+
+        /**
+         * @brief Access the shared instance
+         *
+         * @return BeltTracker&
+         */
+        static BeltTracker& instance();
+
+        /**
+         * @brief Associate the parts of a belt camera image with the tracks
+         *
+         * @param stamp Time of the image
+         * @param detections Parts of the image, in the world frame
+         */
+        void observe(const ros::Time& stamp, const std::vector<Product>& detections);
+
+        /**
+         * @brief Record a part crossing a breakbeam
+         *
+         * The position of the beam is looked up once per frame. A part
+         * already fixed at this beam is not fixed again.
+         *
+         * @param frame TF frame of the breakbeam
+         * @param stamp Time of the crossing
+         */
+        void breakbeam(const std::string& frame, const ros::Time& stamp);
+
+        /**
+         * @brief Estimated belt velocity along the world y axis
+         *
+         * @return double Velocity in m/s, 0 until two observations of a part
+         */
+        double velocity() const;
+
+        /**
+         * @brief Next part to reach a position along the belt
+         *
+         * @param pick_y Position along the world y axis
+         * @param after Only parts reaching pick_y after this time are considered
+         * @param arrival Filled with the time the part reaches pick_y
+         * @param part Filled with the part, Product::world_pose is predicted at arrival
+         * @return true A part will reach pick_y
+         * @return false No part upstream of pick_y, or belt velocity unknown
+         */
+        bool nextArrival(double pick_y, const ros::Time& after, ros::Time& arrival, Product& part) const;
+
+        /**
+         * @brief Wait until a part is predicted to reach a position along the belt
+         *
+         * @param pick_y Position along the world y axis
+         * @param deadline Time after which the wait gives up
+         * @param arrival Filled with the time the part reaches pick_y
+         * @param part Filled with the part, Product::world_pose is predicted at arrival
+         * @return true A part will reach pick_y
+         * @return false No prediction before the deadline
+         */
+        bool waitForArrival(double pick_y, const ros::Time& deadline, ros::Time& arrival, Product& part) const;
+
+        /**
+         * @brief Predicted position of a part along the world y axis
+         *
+         * @param id Track id
+         * @param stamp Time of the prediction
+         * @param y Filled with the predicted position
+         * @return true Track exists
+         * @return false Unknown id or part gone
+         */
+        bool predict(std::uint32_t id, const ros::Time& stamp, double& y) const;
+
+        /**
+         * @brief Drop a part taken off the belt
+         *
+         * @param id Track id
+         */
+        void picked(std::uint32_t id);
+
+        private:
+        struct Track {
+            Product part;      // latest observation, Product::type is empty until the camera sees the part
+            double y;          // position along the belt at the observation
+            ros::Time stamp;   // time of the observation
+            std::string beam;  // frame of the last breakbeam that fixed the part
+            int missed{0};
+        };
+
+        BeltTracker() = default;
+        double predicted(const Track& track, const ros::Time& stamp) const;
+        void correct(Track& track, double y, const ros::Time& stamp);
+        bool arrivalOf(const Track& track, double pick_y, ros::Time& arrival) const;
+        // nextArrival() with mutex_ held
+        bool firstArrival(double pick_y, const ros::Time& after, ros::Time& arrival, Product& part) const;
+        void expire(const ros::Time& stamp);
+        bool beamPosition(const std::string& frame, double& y);
+
+        mutable std::mutex mutex_;
+        mutable std::condition_variable changed_;
+        std::map<std::uint32_t, Track> tracks_;
+        std::uint32_t next_id_{1};
+        double velocity_{0};
+        bool velocity_known_{false};
+        // extent of the belt seen by the camera
+        double view_min_y_{0};
+        double view_max_y_{0};
+        bool view_known_{false};
+        std::map<std::string, double> beams_;
+    };
+}  // namespace motioncontrol
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef BIN_SLOTS_H
+#define BIN_SLOTS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <ros/ros.h>
+#include <geometry_msgs/Point.h>
+#include <geometry_msgs/Pose.h>
+#include "../util/util.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Occupancy of the eight bins and allocation of free slots in them
+     *
+     * Each bin is a grid of kCellSize cells. A cell is occupied when it
+     * lies under the footprint of a part seen by the bin cameras, or of a
+     * slot handed out by allocate() that the cameras have not confirmed
+     * yet. A footprint is a disc whose radius depends on the part type.
+     * A slot fits when its footprint, grown by kClearance, lies inside the
+     * bin and covers no occupied cell, so parts staged one after the other
+     * never land on top of each other.
+     */
+    class BinSlots {
+        public:
+        /// Number of bins
+        static constexpr int kBinCount = 8;
+        /// Side of a grid cell, in meters
+        static constexpr double kCellSize = 0.05;
+        /// Half of the inner side of a bin, in meters
+        static constexpr double kBinHalfSide = 0.3;
+        /// Free space kept around a slot, in meters
+        static constexpr double kClearance = 0.03;
+        /// Time an allocated slot stays occupied while no part is seen there, in seconds
+        static constexpr double kReservationTime = 30.0;
+
+        /**
+         * @brief Access the shared instance
+         *
+         * @return BinSlots&
+         */
+        static BinSlots& instance();
+
+        /**
+         * @brief Replace the parts of four bins with those of a bin camera image
+         *
+         * @param first_bin Index of the first bin, from 0
+         * @param bins Parts in each bin, in the world frame
+         */
+        void update(std::size_t first_bin, const std::array<std::vector<Product>,4>& bins);
+
+        /**
+         * @brief Radius of the footprint of a part type
+         *
+         * @param type Part type, the empty type gets the largest footprint
+         * @return double Radius in meters
+         */
+        static double footprint(PartType type);
+
+        /**
+         * @brief Center of a bin at the height parts are placed
+         *
+         * @param bin Bin number, from 1 to 8
+         * @return geometry_msgs::Point
+         */
+        static geometry_msgs::Point center(int bin);
+
+        /**
+         * @brief Check that a part fits at a position of a bin
+         *
+         * @param bin Bin number, from 1 to 8
+         * @param at Position in the world frame
+         * @param type Part type
+         * @return true The footprint is inside the bin and free
+         * @return false
+         */
+        bool fits(int bin, const geometry_msgs::Point& at, PartType type) const;
+
+        /**
+         * @brief Find and reserve the free slot closest to the robot
+         *
+         * @param type Part type to place
+         * @param robot Position the distance is measured from
+         * @param bins Bins to consider, from 1 to 8
+         * @param bin Filled with the bin of the slot
+         * @param slot Filled with the slot pose in the world frame, with identity orientation
+         * @return true A slot was reserved
+         * @return false No bin has room for the part
+         */
+        bool allocate(PartType type, const geometry_msgs::Point& robot, const std::vector<int>& bins,
+            int& bin, geometry_msgs::Pose& slot);
+
+        /**
+         * @brief Reserve a slot chosen by the caller
+         *
+         * @param bin Bin number, from 1 to 8
+         * @param at Position in the world frame
+         * @param type Part type
+         * @return true The slot was free and is now reserved
+         * @return false The part does not fit there
+         */
+        bool reserve(int bin, const geometry_msgs::Point& at, PartType type);
+
+        /**
+         * @brief Number of free cells of a bin
+         *
+         * @param bin Bin number, from 1 to 8
+         * @return std::size_t
+         */
+        std::size_t freeCells(int bin) const;
+
+        private:
+        static constexpr int kCells = static_cast<int>(2 * kBinHalfSide / kCellSize + 0.5);
+
+        struct Disc {
+            geometry_msgs::Point at;
+            double radius;
+            ros::Time stamp;  // reservations only
+        };
+        struct Bin {
+            std::vector<Disc> parts;
+            std::vector<Disc> reserved;
+            std::array<std::uint8_t, kCells * kCells> cells{};
+        };
+
+        BinSlots() = default;
+        static bool valid(int bin);
+        bool fitsLocked(int bin, const geometry_msgs::Point& at, double radius) const;
+        void reserveLocked(int bin, const geometry_msgs::Point& at, double radius);
+        void rasterize(Bin& bin, const geometry_msgs::Point& center);
+
+        mutable std::mutex mutex_;
+        std::array<Bin, kBinCount> bins_;
+    };
+}  // namespace motioncontrol
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef DEPTH_LOCALIZER_H
+#define DEPTH_LOCALIZER_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+#include <sensor_msgs/PointCloud.h>
+#include <tf2/LinearMath/Transform.h>
+#include "depth_pipeline.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Parts on the bins found by a depth camera
+     *
+     * A standalone localizer: the control loop still picks the parts
+     * seen by the logical cameras, and a sensor blackout silences the
+     * depth camera as well. Each cloud is moved to the world frame and
+     * run through DepthPipeline, the parts of the latest cloud are kept
+     * for latest(). The depth camera reports shapes, not part types, so
+     * the parts found have no type.
+     */
+    class DepthLocalizer {
+        public:
+        /**
+         * @brief Access the shared instance
+         *
+         * @return DepthLocalizer&
+         */
+        static DepthLocalizer& instance();
+
+        /**
+         * @brief Locate the parts of a depth camera cloud
+         *
+         * The pose of the camera is looked up once per frame.
+         *
+         * @param cloud Cloud in the frame of its header
+         */
+        void process(const sensor_msgs::PointCloud& cloud);
+
+        /**
+         * @brief Parts of the latest cloud
+         *
+         * @param parts Filled with the parts, in the world frame
+         * @param stamp Filled with the time of the cloud
+         * @return true A cloud was processed
+         * @return false No cloud yet
+         */
+        bool latest(std::vector<DepthCluster>& parts, ros::Time& stamp) const;
+
+        private:
+        DepthLocalizer() = default;
+        bool frameInWorld(const std::string& frame, tf2::Transform& frame_in_world);
+
+        // buffers of the cloud being processed, one cloud at a time
+        std::mutex process_mutex_;
+        PointBatch points_;
+        PointBatch world_points_;
+        DepthPipeline pipeline_;
+        std::vector<DepthCluster> found_;
+
+        mutable std::mutex mutex_;
+        std::vector<DepthCluster> parts_;
+        ros::Time stamp_;
+        bool received_{false};
+        std::map<std::string, tf2::Transform> frames_;
+    };
+}  // namespace motioncontrol
+
+#endif
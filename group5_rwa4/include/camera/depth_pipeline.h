@@ -0,0 +1,126 @@
+#ifndef DEPTH_PIPELINE_H
+#define DEPTH_PIPELINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <geometry_msgs/Point.h>
+#include "../util/point_batch.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Part found in a depth camera cloud
+     */
+    struct DepthCluster {
+        geometry_msgs::Point centroid;  // of the top face, world frame
+        double yaw;                     // major axis about the world z axis, in (-pi/2, pi/2]
+        double length;                  // extent of the top face along the major axis
+        double width;                   // extent of the top face across the major axis
+        double height;                  // top of the part above the support plane
+        std::size_t voxels;
+    };
+
+    /**
+     * @brief Localization of the parts lying on a horizontal surface in a point cloud
+     *
+     * Runs on a cloud already in the world frame, in three stages:
+     * - voxelize() averages the points of each kVoxelSize cube, dropping
+     *   the points without a return,
+     * - removePlane() finds the support plane (the bin bottoms) as the
+     *   highest well populated height and keeps the voxels above it,
+     * - cluster() joins touching voxels and reports the centroid and the
+     *   principal axis of the top face of each group with a part-sized
+     *   footprint.
+     *
+     * Every buffer is a member that only grows, so once the largest cloud
+     * has been seen a frame runs without touching the heap.
+     */
+    class DepthPipeline {
+        public:
+        /// Side of a voxel, in meters
+        static constexpr float kVoxelSize = 0.01f;
+        /// Height bins of the support plane search, in meters
+        static constexpr float kPlaneBinSize = 0.005f;
+        /// Share of the most populated height bin a height bin needs to be the support plane
+        static constexpr float kPlaneShare = 0.25f;
+        /// Voxels lower than this above the support plane belong to it, in meters
+        static constexpr float kPlaneTolerance = 0.008f;
+        /// Voxels this close to the top of a part belong to its top face, in meters
+        static constexpr float kTopBand = 0.012f;
+        /// Fewest voxels of a part
+        static constexpr std::size_t kMinVoxels = 8;
+        /// Longest part, larger groups are bin walls or the belt
+        static constexpr double kMaxLength = 0.3;
+
+        /**
+         * @brief Run the three stages
+         *
+         * @param points Cloud in the world frame
+         * @param clusters Filled with the parts found, capacity is reused
+         */
+        void process(const PointBatch& points, std::vector<DepthCluster>& clusters);
+
+        /**
+         * @brief Average the points falling in each voxel
+         *
+         * @param points Cloud in the world frame
+         * @return std::size_t Number of occupied voxels
+         */
+        std::size_t voxelize(const PointBatch& points);
+
+        /**
+         * @brief Drop the voxels of the support plane and below it
+         *
+         * @return std::size_t Number of voxels left
+         */
+        std::size_t removePlane();
+
+        /**
+         * @brief Group the voxels left into parts
+         *
+         * @param clusters Filled with the parts found, capacity is reused
+         */
+        void cluster(std::vector<DepthCluster>& clusters);
+
+        /**
+         * @brief Height of the support plane found by the latest removePlane()
+         *
+         * @return float Height in the world frame
+         */
+        float planeHeight() const { return plane_z_; }
+
+        private:
+        struct Keyed {
+            std::uint64_t key;
+            std::uint32_t index;
+        };
+        struct Stats {
+            std::uint32_t count;
+            float top;
+            // moments of the voxels of the top face
+            std::uint32_t face;
+            double sx, sy, sz, sxx, syy, sxy;
+            // principal axis and extents along it
+            double yaw, ux, uy, lo_u, hi_u, lo_v, hi_v;
+        };
+
+        std::uint32_t root(std::uint32_t i);
+
+        // voxel key: x, y and z cell indices packed with as many bits as the cloud needs
+        unsigned y_shift_{0};
+        unsigned x_shift_{0};
+        unsigned key_bits_{0};
+        std::vector<Keyed> keyed_;
+        std::vector<Keyed> sorted_;
+        // occupied voxels sorted by key
+        std::vector<std::uint64_t> keys_;
+        PointBatch voxels_;
+        std::vector<std::uint32_t> histogram_;
+        std::vector<std::uint32_t> parent_;
+        std::vector<Stats> stats_;
+        float plane_z_{0};
+    };
+}  // namespace motioncontrol
+
+#endif
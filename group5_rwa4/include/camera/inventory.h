@@ -0,0 +1,161 @@
+#ifndef INVENTORY_H
+#define INVENTORY_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "../util/util.h"
+#include "../util/registry.h"
+#include "part_tracker.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Parts of each type available to the robots
+     *
+     * Fed with every image of the scanned logical cameras (bins and AGVs
+     * at the assembly stations), the same cameras the control loop picks
+     * from. A part is known by the track id given by PartTracker, so a
+     * part seen by two cameras counts once. Free parts are the ones seen
+     * now and neither reserved nor consumed. Reserving takes a part out of
+     * the free ones while a robot goes for it, consuming records that it
+     * was used. A part whose track PartTracker drops stops being free,
+     * and a free part that moves keeps its latest pose. All the counts of
+     * a type are read in constant time.
+     */
+    class Inventory {
+        public:
+        /**
+         * @brief Counts of one part type
+         */
+        struct Counts {
+            std::size_t free;
+            std::size_t reserved;
+            std::size_t consumed;
+        };
+
+        /**
+         * @brief Outcome of a feasibility check of a shipment
+         */
+        struct ShipmentCheck {
+            std::string shipment_type;
+            // Parts of each type that cannot be supplied
+            std::map<PartType, std::size_t> missing;
+
+            bool feasible() const { return missing.empty(); }
+        };
+
+        /**
+         * @brief Access the shared instance
+         *
+         * @return Inventory&
+         */
+        static Inventory& instance();
+
+        /**
+         * @brief Replace the parts seen by a camera with those of its latest image
+         *
+         * @param camera Scanned logical camera
+         * @param parts Parts of the image, with their track id
+         */
+        void update(SensorId camera, const std::vector<Product>& parts);
+
+        /**
+         * @brief Follow the identity changes reported by PartTracker
+         *
+         * @param events Events taken from the tracker, oldest first
+         */
+        void apply(const std::vector<PartEvent>& events);
+
+        /**
+         * @brief Counts of a part type
+         *
+         * @param type Part type
+         * @return Counts All zero for a type never seen
+         */
+        Counts counts(PartType type) const;
+
+        /**
+         * @brief Free parts of a type
+         *
+         * @param type Part type
+         * @return std::vector<Product> Latest detection of each free part
+         */
+        std::vector<Product> freeParts(PartType type) const;
+
+        /**
+         * @brief Take a free part out of the free ones
+         *
+         * @param part Part, Product::type and Product::id are used
+         * @return true The part was free
+         * @return false The part is not free
+         */
+        bool reserve(const Product& part);
+
+        /**
+         * @brief Record that a part was used, reserved or not
+         *
+         * A part without a track id uses up the free part of its type
+         * closest to Product::world_pose.
+         *
+         * @param part Part, Product::type, Product::id and Product::world_pose are used
+         */
+        void consume(const Product& part);
+
+        /**
+         * @brief Check that the free parts in the bins cover a kitting shipment
+         *
+         * @param products Parts of the shipment
+         * @return ShipmentCheck Parts that cannot be supplied
+         */
+        ShipmentCheck check(const std::vector<Product>& products) const;
+
+        /**
+         * @brief Check that the free parts cover every shipment of an order
+         *
+         * Kitting shipments draw on the parts in the bins. An assembly
+         * shipment draws on the parts on the AGVs at its station and on
+         * those the kitting shipments of the order deliver there, so a
+         * part is not charged to both. Shipments are checked in order,
+         * each one using up the parts before the next one is checked.
+         *
+         * @param order Order
+         * @return std::vector<ShipmentCheck> Kitting shipments first, then assembly shipments
+         */
+        std::vector<ShipmentCheck> check(const Order& order) const;
+
+        private:
+        struct Instance {
+            Product part;
+            int cameras{0};  // cameras seeing the part
+        };
+        struct Entry {
+            std::unordered_map<std::uint32_t, Instance> free;
+            std::size_t reserved{0};
+            std::size_t consumed{0};
+        };
+
+        using Stock = std::unordered_map<PartType, std::size_t>;
+
+        Inventory() = default;
+        ShipmentCheck check(const std::vector<Product>& products, Stock& remaining) const;
+        // free parts of each type in the bins, and at each assembly station, with mutex_ held
+        void stock(Stock& bins, std::map<std::string, Stock>& stations) const;
+
+        mutable std::mutex mutex_;
+        std::unordered_map<PartType, Entry> types_;
+        // type and id of the parts of the latest image of each camera
+        std::array<std::vector<std::pair<PartType, std::uint32_t> >, kLogicalCameraCount> seen_;
+        std::unordered_set<std::uint32_t> reserved_;
+        std::unordered_set<std::uint32_t> consumed_;
+    };
+}  // namespace motioncontrol
+
+#endif
@@ -1,95 +1,84 @@
 #ifndef LOGICAL_CAMERA_H
 #define LOGICAL_CAMERA_H
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <future>
+#include <mutex>
 #include "../util/util.h"
+#include "../util/transform_service.h"
+#include "../util/registry.h"
+#include "../util/snapshot.h"
+#include "part_tracker.h"
+
+/**
+ * @brief Perception state published by LogicalCamera
+ * 
+ * A list that an image did not change is shared with the previous
+ * version, so publishing an image copies a few pointers. The lists are
+ * never null.
+ */
+struct WorldModel
+{
+    using PartList = std::shared_ptr<const std::vector<Product> >;
+    // Latest parts seen by each logical camera.
+    std::array<PartList,motioncontrol::kLogicalCameraCount> parts;
+    // Parts in each bin, from the bin cameras.
+    std::array<PartList,8> bins;
+    // Latest faulty parts seen by each quality control sensor.
+    std::array<PartList,motioncontrol::kQualityControlCount> faulty_parts;
+    // Time of the latest image of each sensor, zero until it reports.
+    std::array<ros::Time,motioncontrol::kSensorCount> stamps;
+};
+
+/**
+ * @brief Outcome of LogicalCamera::scan()
+ */
+struct ScanResult
+{
+    // Parts seen by each scanned camera, other cameras are left empty.
+    std::array<std::vector<Product>,motioncontrol::kLogicalCameraCount> parts;
+    // Cameras without an image newer than the request when the deadline passed.
+    std::vector<motioncontrol::SensorId> late;
+    // Taken during a sensor blackout: the parts are the last known ones.
+    bool stale{false};
+
+    bool complete() const { return late.empty(); }
+};
 
 class LogicalCamera
 {
     public:
     explicit LogicalCamera(ros::NodeHandle &);
 
-    /// Called when a new LogicalCameraImage message from /ariac/logical_camera_bins0 is received.
-    void logical_camera_bins0_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-    
-    /// Called when a new LogicalCameraImage message from /ariac/logical_camera_bins1 is received.
-    void logical_camera_bins1_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-
-    // Subscribe to the '/ariac/logical_camera_station1' topic.
-    void logical_camera_station1_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-    
-    // Subscribe to the '/ariac/logical_camera_station2' topic.
-    void logical_camera_station2_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-    
-    // Subscribe to the '/ariac/logical_camera_station3' topic.
-    void logical_camera_station3_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-    
-    // Subscribe to the '/ariac/logical_camera_station4' topic.
-    void logical_camera_station4_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-    
-    // Subscribe to the '/ariac/logical_camera_agv1as1' topic.
-    void logical_camera_agv1as1_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-
-    // Subscribe to the '/ariac/logical_camera_agv1as2' topic.
-    void logical_camera_agv1as2_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-
-    // Subscribe to the '/ariac/logical_camera_agv1ks' topic.
-    void logical_camera_agv1ks_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-
-    // Subscribe to the '/ariac/logical_camera_agv2as1' topic.
-    void logical_camera_agv2as1_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-
-    // Subscribe to the '/ariac/logical_camera_agv2as2' topic.
-    void logical_camera_agv2as2_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-
-    // Subscribe to the '/ariac/logical_camera_agv2ks' topic.
-    void logical_camera_agv2ks_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-
-    // Subscribe to the '/ariac/logical_camera_agv3as3' topic.
-    void logical_camera_agv3as3_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-
-    // Subscribe to the '/ariac/logical_camera_agv3as4' topic.
-    void logical_camera_agv3as4_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-
-    // Subscribe to the '/ariac/logical_camera_agv3ks' topic.
-    void logical_camera_agv3ks_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-
-    // Subscribe to the '/ariac/logical_camera_agv4as3' topic.
-    void logical_camera_agv4as3_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-
-    // Subscribe to the '/ariac/logical_camera_agv4as4' topic.
-    void logical_camera_agv4as4_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-
-    // Subscribe to the '/ariac/logical_camera_agv4ks' topic.
-    void logical_camera_agv4ks_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-
-    // Subscribe to the '/ariac/logical_camera_belt' topic.
-    void logical_camera_belt_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-
-    // Subscribe to the '/ariac/quality_control_sensor_1' topic.
-    void quality_control_sensor1_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-
-    // Subscribe to the '/ariac/quality_control_sensor_2' topic.
-    void quality_control_sensor2_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-    
-    // Subscribe to the '/ariac/quality_control_sensor_3' topic.
-    void quality_control_sensor3_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-    
-    // Subscribe to the '/ariac/quality_control_sensor_4' topic.
-    void quality_control_sensor4_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
- 
-    // List of all the models found by the logical cameras.
-    std::array<std::vector<Product>,19> camera_parts_list;
-
-    // Buffer for transform.
-    tf2_ros::Buffer tfBuffer;
+    /**
+     * @brief Handles an image of any logical camera or quality control sensor.
+     * 
+     * Every subscription of the class routes through here. The sensor
+     * entry of the registry decides whether the parts go to the world
+     * model, to the bins or to the faulty parts of an AGV.
+     * 
+     * @param sensor Sensor that published the image
+     * @param image_msg Image
+     */
+    void ingest(motioncontrol::SensorId sensor, const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
 
-    // Tf Listener
-    tf2_ros::TransformListener tfListener;
+    /**
+     * @brief Current version of the world model.
+     * 
+     * A single atomic load that never waits for the camera callbacks. The
+     * version stays valid and unchanged for as long as it is held.
+     * 
+     * @return motioncontrol::Snapshot<WorldModel>::Ptr 
+     */
+    motioncontrol::Snapshot<WorldModel>::Ptr snapshot() const{
+        return world_.load();
+    }
 
-    // Array of boolean to check the camera data only once when needed. 
-    bool get_cam[19] = {true,true,true,true,true,true,true,true,true,true,true,true,true,true,true,true,true,true,true};
+    // Buffer for transform, shared with the rest of the node.
+    tf2_ros::Buffer& tfBuffer;
 
-    // Array of boolean to check the quality control sensor data only once when needed.
-    bool get_faulty_cam[4] = {true,true,true,true};
 
     /// callback for timer
     void callback(const ros::TimerEvent& event);
@@ -97,38 +86,86 @@ class LogicalCamera
     /// Accessor for boolean check of timer
     bool get_timer();
 
-    std::vector<Product> faulty_part_list_;
     
     /**
-     * @brief Detects the parts in vicinity of all the logical cameras and stores data of each model. 
+     * @brief Subscribes once to every logical camera of the registry.
      * 
-     * @return std::array<std::vector<Product>,19> 
+     * Each camera then keeps its latest list of parts up to date, so the
+     * queries below answer from memory without waiting.
      */
-    std::array<std::vector<Product>,19> findparts();
+    void init();
     /**
-     * @brief Populates the map according to product type
+     * @brief Scanned logical cameras of the registry (bins and assembly stations).
      * 
-     * @param list List of parts seen by by logical cameras 
+     * @return std::vector<motioncontrol::SensorId> 
+     */
+    static std::vector<motioncontrol::SensorId> scanned_cameras();
+    /**
+     * @brief Requests a fresh scan of some logical cameras.
+     * 
+     * The scan completes as soon as every camera has delivered an image
+     * newer than the request, or when the deadline passes. During a
+     * sensor blackout it completes at once with the last known parts,
+     * marked stale.
+     * 
+     * @param cameras Cameras to scan
+     * @param deadline Time after which the scan completes with the latest images
+     * @return std::future<ScanResult> Parts of the scanned cameras and the cameras that were late
+     */
+    std::future<ScanResult> scan(const std::vector<motioncontrol::SensorId>& cameras, const ros::Time& deadline);
+    /**
+     * @brief Snapshot of the parts currently seen by the scanned logical cameras.
+     * 
+     * Cameras that are not scanned (stations, kitting stations, belt) are
+     * left empty, use get_parts() for them.
+     * 
+     * @return std::array<std::vector<Product>,motioncontrol::kLogicalCameraCount> 
+     */
+    std::array<std::vector<Product>,motioncontrol::kLogicalCameraCount> findparts();
+    /**
+     * @brief Parts currently seen by one logical camera.
+     * 
+     * @param camera Logical camera
+     * @return std::vector<Product> Parts of the latest image
+     */
+    std::vector<Product> get_parts(motioncontrol::SensorId camera);
+    /**
+     * @brief Time of the latest image of a logical camera.
+     * 
+     * @param camera Logical camera
+     * @return ros::Time Zero if the camera has not reported yet
      */
-    void segregate_parts(std::array<std::vector<Product>,19> list);
+    ros::Time get_stamp(motioncontrol::SensorId camera);
     /**
-     * @brief Get the list of faulty parts
+     * @brief Populates the map according to product type
      * 
-     * @return std::vector<Product> List of faulty parts
+     * @param list List of parts seen by by logical cameras 
      */
-    std::vector<Product> get_faulty_part_list();  
+    void segregate_parts(std::array<std::vector<Product>,motioncontrol::kLogicalCameraCount> list);
     /**
-     * @brief Checks if there is a sensor blackout.
+     * @brief Faulty parts currently seen on an AGV
      * 
-     * @return true 
-     * @return false 
+     * @param agv "agv1".."agv4"
+     * @return std::vector<Product> Faulty parts of the latest image of the quality control sensor
      */
-    double CheckBlackout();
+    std::vector<Product> get_faulty_parts(const std::string& agv);
     /**
-     * @brief Query the quality control sensors to check for faulty parts, if any
+     * @brief Waits for the verdict of the quality control sensor after a placement
+     * 
+     * Returns as soon as the sensor watching the AGV delivers an image
+     * newer than the call, or after the timeout with the latest image.
+     * Returns false at once during a sensor blackout, the placement has
+     * to be checked again when the sensors are back.
      * 
+     * @param agv "agv1".."agv4"
+     * @param placed Pose of the placed part in the world frame
+     * @param timeout Maximum time to wait for a new image
+     * @param faulty Filled with the faulty part closest to the placed pose
+     * @return true The part at the placed pose is faulty
+     * @return false No faulty part at the placed pose
      */
-    void query_faulty_cam();
+    bool wait_for_faulty_part(const std::string& agv, const geometry_msgs::Pose& placed,
+      const ros::Duration& timeout, Product& faulty);
     /**
      * @brief Get the generated map of parts 
      * 
@@ -140,21 +177,67 @@ class LogicalCamera
 
     std::array<std::vector<Product>,8> get_bin_list();
 
+    /**
+     * @brief Tracker giving the parts seen by the logical cameras a persistent id
+     * 
+     * @return motioncontrol::PartTracker& Appeared, moved and disappeared events and current tracks
+     */
+    motioncontrol::PartTracker& get_tracker(){
+        return tracker_;
+    }
+
+    /**
+     * @brief Images of a sensor since init()
+     */
+    struct FrameCounters
+    {
+        std::uint64_t processed;  // images that changed the world model or the faulty parts
+        std::uint64_t skipped;    // images identical to the previous one
+    };
+    /**
+     * @brief Processed and skipped images of a logical camera or quality control sensor.
+     * 
+     * @param sensor Sensor
+     * @return FrameCounters 
+     */
+    FrameCounters get_frame_counters(motioncontrol::SensorId sensor);
+
     std::vector<int> get_ebin_list();
 
     private:
+    ros::Subscriber subscribe(motioncontrol::SensorId sensor);
+    void store_stamp(motioncontrol::SensorId sensor);
+    void store_faulty_parts(motioncontrol::SensorId sensor, std::vector<Product>& parts);
+    static bool quality_control_of(const std::string& agv, std::size_t& n);
+    void store_parts(motioncontrol::SensorId camera, std::vector<Product>& parts);
+    void store_bins(std::size_t first_bin, std::array<std::vector<Product>,4>&& bins);
+    ScanResult wait_for_scan(const std::vector<motioncontrol::SensorId>& cameras, const ros::Time& requested, const ros::Time& deadline);
+
     ros::NodeHandle node_;
-    ros::Subscriber quality_control_sensor1_subscriber;
-    ros::Subscriber quality_control_sensor2_subscriber;
-    ros::Subscriber quality_control_sensor3_subscriber;
-    ros::Subscriber quality_control_sensor4_subscriber;
+    std::array<ros::Subscriber, motioncontrol::kLogicalCameraCount> camera_subscribers_;
+    // Written by ingest() on the spinner threads, read without locking.
+    motioncontrol::Snapshot<WorldModel> world_;
+    // Notified whenever a camera delivers an image, the mutex only serves the waits.
+    std::mutex frame_mutex_;
+    std::condition_variable frame_arrived_;
+    void notify_frame();
+    motioncontrol::PartTracker tracker_;
+    // Signature of the latest processed image of each sensor, and of the current one.
+    std::array<std::vector<std::int64_t>, motioncontrol::kSensorCount> signatures_;
+    std::array<std::vector<std::int64_t>, motioncontrol::kSensorCount> next_signatures_;
+    struct AtomicFrameCounters
+    {
+        std::atomic<std::uint64_t> processed{0};
+        std::atomic<std::uint64_t> skipped{0};
+    };
+    std::array<AtomicFrameCounters, motioncontrol::kSensorCount> sensor_frames_;
+    // Parts being built from the current image of each sensor.
+    std::array<std::vector<Product>, motioncontrol::kSensorCount> scratch_;
+    std::array<ros::Subscriber, motioncontrol::kQualityControlCount> quality_control_sensor_subscribers_;
     bool logflag_{};
     ros::Timer timer;
     bool wait{false};
     std::map<std::string, std::vector<Product> > camera_map_;
-    double blackout_time_ = 0;
-    std::array<std::vector<Product>,8> bins_list;
-    std::vector<int> empty_bin;
     
 };
 
@@ -0,0 +1,94 @@
+#ifndef PART_INDEX_H
+#define PART_INDEX_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <geometry_msgs/Point.h>
+#include "../util/util.h"
+#include "../util/registry.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Uniform grid over the world poses of the detected parts
+     *
+     * The index is built from a map of parts by type (see
+     * LogicalCamera::get_camera_map) and points into that map, so a part
+     * returned by a query can be marked PartStatus::kProcessed in place. The map must
+     * outlive the index and must not gain or lose parts while it is used.
+     * Distances are measured in the XY plane.
+     */
+    class PartIndex {
+        public:
+        /// Side of a grid cell, in meters
+        static constexpr double kCellSize = 0.5;
+
+        /**
+         * @brief Index the parts of a map
+         *
+         * @param parts Parts by type
+         */
+        explicit PartIndex(std::map<std::string, std::vector<Product> >& parts);
+
+        /**
+         * @brief Index the parts of a map seen by some cameras
+         *
+         * @param parts Parts by type
+         * @param cameras Cameras whose parts are indexed (e.g., the bin cameras)
+         */
+        PartIndex(std::map<std::string, std::vector<Product> >& parts, const std::vector<SensorId>& cameras);
+
+        /**
+         * @brief Closest part of a type whose status is PartStatus::kFree
+         *
+         * @param type Part type
+         * @param from Point to measure from (e.g., a robot or a placement target)
+         * @return Product* Closest free part, nullptr if there is none
+         */
+        Product* nearestFree(PartType type, const geometry_msgs::Point& from) const;
+
+        /**
+         * @brief Parts in a bin
+         *
+         * @param bin Bin number, from 1 to 8
+         * @return std::vector<Product*> Parts in the bin, free or not
+         */
+        std::vector<Product*> inBin(int bin) const;
+
+        /**
+         * @brief Parts within a distance of a point
+         *
+         * @param center Point to measure from
+         * @param radius Distance in meters
+         * @return std::vector<Product*> Parts of any type and status
+         */
+        std::vector<Product*> within(const geometry_msgs::Point& center, double radius) const;
+
+        /**
+         * @brief Number of indexed parts
+         */
+        std::size_t size() const { return size_; }
+
+        private:
+        struct Grid {
+            std::unordered_map<std::int64_t, std::vector<Product*> > cells;
+            int min_x{0}, max_x{-1}, min_y{0}, max_y{-1};
+
+            void insert(int cx, int cy, Product* part);
+            const std::vector<Product*>* find(int cx, int cy) const;
+        };
+
+        static int cellOf(double v);
+        void add(Product& part);
+
+        Grid all_;
+        std::unordered_map<PartType, Grid> by_type_;
+        std::map<int, std::vector<Product*> > by_bin_;
+        std::size_t size_{0};
+    };
+}  // namespace motioncontrol
+
+#endif
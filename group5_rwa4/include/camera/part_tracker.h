@@ -0,0 +1,111 @@
+#ifndef PART_TRACKER_H
+#define PART_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+#include "../util/util.h"
+#include "../util/registry.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Change of a tracked part reported by PartTracker
+     */
+    struct PartEvent {
+        enum class Type { kAppeared, kMoved, kDisappeared };
+        Type type;
+        Product part;  // latest detection, Product::id holds the track id
+    };
+
+    /**
+     * @brief Gives the parts seen by the logical cameras a persistent id
+     *
+     * Each image is associated with the current tracks by greedy nearest
+     * neighbour on the world position, gated by type and distance. Tracks
+     * may be matched by any camera, so a part seen by overlapping cameras
+     * keeps its id. A track is dropped once the camera that saw it last
+     * misses it on kMissedFrames images in a row. Ids count up from 1.
+     */
+    class PartTracker {
+        public:
+        /// Largest distance between a track and a detection of the same part, in meters
+        static constexpr double kGate = 0.1;
+        /// Displacement reported as a move, in meters
+        static constexpr double kMoveThreshold = 0.02;
+        /// Images of the owning camera without the part before it is dropped
+        static constexpr int kMissedFrames = 3;
+        /// Events kept until takeEvents() is called, older ones are dropped; LogicalCamera takes them after every image
+        static constexpr std::size_t kMaxEvents = 1024;
+
+        /**
+         * @brief Associate the parts of an image with the tracks
+         *
+         * Sets Product::id of every detection.
+         *
+         * @param camera Camera that produced the image
+         * @param detections Parts of the image, in the world frame
+         */
+        void update(SensorId camera, std::vector<Product>& detections);
+
+        /**
+         * @brief Count an image identical to the previous one of a camera
+         *
+         * The tracks of the camera that the previous image missed are
+         * missed again, so a part that left the view is dropped even when
+         * the camera keeps sending the same image.
+         *
+         * @param camera Camera that produced the image
+         */
+        void unchanged(SensorId camera);
+
+        /**
+         * @brief Events since the previous call, oldest first
+         *
+         * @return std::vector<PartEvent>
+         */
+        std::vector<PartEvent> takeEvents();
+
+        /**
+         * @brief Latest detection of every track
+         *
+         * @return std::vector<Product>
+         */
+        std::vector<Product> parts() const;
+
+        /**
+         * @brief Latest detection of a track
+         *
+         * @param id Track id
+         * @param part Filled with the detection
+         * @return true Track exists
+         * @return false Unknown id or part gone
+         */
+        bool find(std::uint32_t id, Product& part) const;
+
+        private:
+        struct Track {
+            Product part;
+            geometry_msgs::Pose reported;  // pose of the last appeared or moved event
+            SensorId camera;
+            int missed{0};
+        };
+
+        void emit(PartEvent::Type type, const Product& part);
+        // count a miss for the tracks of a camera selected by the caller, drop those missed too often
+        template <class Missed>
+        void countMisses(SensorId camera, Missed missed);
+
+        mutable std::mutex mutex_;
+        std::map<std::uint32_t, Track> tracks_;
+        std::uint32_t next_id_{1};
+        std::deque<PartEvent> events_;
+    };
+}  // namespace motioncontrol
+
+#endif
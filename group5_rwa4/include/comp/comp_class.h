@@ -1,6 +1,9 @@
 #ifndef COMP_CLASS_H
 #define COMP_CLASS_H
+#include <condition_variable>
+#include <mutex>
 #include "../util/util.h"
+#include "order_store.h"
 
 class MyCompetitionClass
 {
@@ -56,23 +59,23 @@ public:
   void order_callback(const nist_gear::Order::ConstPtr & order_msg);
 
   /**
-   * @brief Gets the order list object
+   * @brief Current version of the order list, without copying it
    * 
-   * @return std::vector<Order> 
+   * A single atomic load that never waits for order_callback(). The
+   * version number grows with every order received.
+   * 
+   * @return motioncontrol::OrderStore::Ptr 
    */
-  std::vector<Order> get_order_list();
-   /**
-   * @brief Checks if there is a sensor blackout.
+  motioncontrol::OrderStore::Ptr get_orders() const;
+
+  /**
+   * @brief Orders received, to wait for a new one
    * 
-   * @return true 
-   * @return false 
+   * @return const motioncontrol::OrderStore& 
    */
-  double CheckBlackout();
+  const motioncontrol::OrderStore& order_store() const;
 
-  // Called when a new LogicalCameraImage message from /ariac/depth_camera_bins1 is received.
-  void depth_camera_bins1_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-  
-  /// Called when a new Proximity message from /ariac/breakbeam0 is received.
+  /// Called on each change of /ariac/breakbeam_0_change, a part crossing the beam when object_detected is set.
   void breakbeam0_callback(const nist_gear::Proximity::ConstPtr & msg);
 
   /// Called when a new Proximity message from /ariac/proximity_sensor_0 is received.
@@ -81,7 +84,7 @@ public:
   /// Called when a new LaserScan message from laser_profiler_0 is received.
   void laser_profiler0_callback(const sensor_msgs::LaserScan::ConstPtr & msg);
 
-  /// Called when a new PointCloud message from depth_camera_bins1 is received.
+  /// Called when a new PointCloud message from /ariac/depth_camera_bins1/depth/points is received.
   void depth_camera_bins1_callback(const sensor_msgs::PointCloud::ConstPtr & pc_msg);
 
   /// Called when a new String message from /ariac/agv1/station is received.
@@ -95,20 +98,22 @@ public:
 
   /// Called when a new String message from /ariac/agv4/station is received.
   void agv4_station_callback(const std_msgs::String::ConstPtr & msg);
-  
-  /// Called when a new LogicalCameraImage message from /ariac/logical_camera_bins0 is received.
-  void logical_camera_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg);
-
-  // Check for high priority, if announced
-  bool high_priority_announced{false};  
-
-  // Check if order1 is announced
-  bool order1_announced{false};
 
   /// callback for timer
   void callback(const ros::TimerEvent& event);
 
   bool conveyor_check();
+
+  /**
+   * @brief Wait for the first part on the conveyor belt
+   * 
+   * Wakes with the breakbeam message that sees it.
+   * 
+   * @param deadline Time after which the wait gives up
+   * @return true Parts are rolling on the conveyor
+   * @return false No part by the deadline
+   */
+  bool wait_for_conveyor(const ros::Time& deadline);
   
 
 private:
@@ -125,15 +130,20 @@ private:
   ros::Subscriber current_score_subscriber_;
   ros::Subscriber competition_state_subscriber_;
   ros::Subscriber competition_clock_subscriber_;
-  ros::Subscriber logical_camera_subscriber_;
   ros::Subscriber orders_subscriber;
   ros::Subscriber break_beam_subscriber_;
-  std::vector<Order> order_list_;
+  ros::Subscriber agv1_station_subscriber_;
+  ros::Subscriber agv2_station_subscriber_;
+  ros::Subscriber agv3_station_subscriber_;
+  ros::Subscriber agv4_station_subscriber_;
+  // Written by order_callback() on a spinner thread, read without locking.
+  motioncontrol::OrderStore order_list_;
   bool order_processed_;
   bool wait{false};
   ros::Timer timer;
-  double blackout_time_ = 0;
   bool parts_rolling_on_conveyor{false};
+  std::mutex conveyor_mutex_;
+  std::condition_variable conveyor_changed_;
 };
 
 #endif
\ No newline at end of file
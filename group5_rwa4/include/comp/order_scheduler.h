@@ -0,0 +1,149 @@
+#ifndef ORDER_SCHEDULER_H
+#define ORDER_SCHEDULER_H
+
+#include <cstdint>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+#include "../util/util.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief One shipment of an order, with the progress made on it
+     *
+     * A product is placed once its processed flag is set, so a shipment
+     * that was preempted resumes with the products it has not placed yet.
+     */
+    struct ShipmentTask {
+        enum class Kind { kKitting, kAssembly };
+        Kind kind;
+        std::string order_id;
+        unsigned short int priority;
+        std::uint64_t sequence;      // announcement order, the earlier shipment goes first among equal priorities
+        std::string shipment_type;
+        std::string destination;     // AGV of a kitting shipment, assembly station of an assembly shipment
+        std::string station_id;      // assembly station the AGV of a kitting shipment is sent to
+        std::vector<Product> products;
+        std::vector<std::size_t> unchecked;  // products placed during a sensor blackout, not checked for faults yet
+        ros::Time announced;
+        std::size_t runs{0};         // times the shipment was handed out by OrderScheduler::next()
+    };
+
+    /**
+     * @brief Priority queue of the shipments of all the orders received
+     *
+     * Fed by MyCompetitionClass::order_callback() on a spinner thread and
+     * drained by the main thread, which runs one shipment at a time. The
+     * runner calls preempt() at its safe points, after a place and before
+     * the next pick, and hands the shipment back with suspend() when a
+     * shipment of a higher priority is waiting. Shipments are handed out
+     * by priority, then suspended ones first, then in the order they were
+     * announced, so a suspended shipment resumes as soon as nothing more
+     * urgent is left. Any number of priority levels is handled; ARIAC
+     * orders carry none, and announcePriority() infers the two it uses.
+     */
+    class OrderScheduler {
+        public:
+        /// Priority of an order announced while the workcell is idle
+        static constexpr unsigned short int kNormalPriority = 1;
+        /// Priority of an order announced while earlier orders are in progress
+        static constexpr unsigned short int kHighPriority = 3;
+
+        using TaskPtr = std::shared_ptr<ShipmentTask>;
+
+        /**
+         * @brief Access the shared instance
+         *
+         * @return OrderScheduler&
+         */
+        static OrderScheduler& instance();
+
+        /**
+         * @brief Priority of an order announced now
+         *
+         * @return unsigned short int kHighPriority if some shipment is
+         * queued or running, kNormalPriority otherwise
+         */
+        unsigned short int announcePriority() const;
+
+        /**
+         * @brief Queue the shipments of an order
+         *
+         * Kitting shipments are queued before assembly shipments, which
+         * use the kits.
+         *
+         * @param order Order, with its priority set
+         */
+        void submit(const Order& order);
+
+        /**
+         * @brief Take the most urgent shipment
+         *
+         * @return TaskPtr nullptr if no shipment is waiting
+         */
+        TaskPtr next();
+
+        /**
+         * @brief Whether a running shipment should give way
+         *
+         * @param task Running shipment
+         * @return true A shipment of a higher priority is waiting
+         * @return false Keep going
+         */
+        bool preempt(const ShipmentTask& task) const;
+
+        /**
+         * @brief Hand back a preempted shipment, it resumes later
+         *
+         * @param task Shipment returned by next()
+         */
+        void suspend(const TaskPtr& task);
+
+        /**
+         * @brief Report a shipment as done
+         *
+         * @param task Shipment returned by next()
+         */
+        void complete(const TaskPtr& task);
+
+        /**
+         * @brief Wait for a shipment to be queued
+         *
+         * @param deadline Time after which the wait gives up
+         * @return true A shipment is waiting
+         * @return false Nothing to do at the deadline
+         */
+        bool waitForWork(const ros::Time& deadline) const;
+
+        /**
+         * @brief Whether every shipment received is done
+         *
+         * @return true Nothing queued or running
+         * @return false Work left
+         */
+        bool idle() const;
+
+        OrderScheduler(const OrderScheduler&) = delete;
+        OrderScheduler& operator=(const OrderScheduler&) = delete;
+
+        private:
+        OrderScheduler() = default;
+        // heap order, the most urgent shipment on top
+        static bool lessUrgent(const TaskPtr& a, const TaskPtr& b);
+
+        mutable std::mutex mutex_;
+        mutable std::condition_variable queued_;
+        std::vector<TaskPtr> heap_;
+        TaskPtr running_;
+        std::uint64_t sequence_{0};
+        // shipments left by order
+        std::map<std::string, std::size_t> remaining_;
+    };
+}  // namespace motioncontrol
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef ORDER_STORE_H
+#define ORDER_STORE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <ros/ros.h>
+#include "../util/util.h"
+#include "../util/snapshot.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Orders received so far, as versioned read-only views
+     *
+     * Each order is stored once and shared by every view published after
+     * it, so adding an order copies one pointer per order instead of the
+     * orders with their shipments and products. The version grows by one
+     * with every order. Readers either poll version() or block in
+     * waitForChange() until an order newer than the view they hold
+     * arrives.
+     */
+    class OrderStore {
+        public:
+        using OrderPtr = std::shared_ptr<const Order>;
+        using Orders = std::vector<OrderPtr>;
+        using Ptr = Snapshot<Orders>::Ptr;
+
+        OrderStore() = default;
+        OrderStore(const OrderStore&) = delete;
+        OrderStore& operator=(const OrderStore&) = delete;
+
+        /**
+         * @brief Current view, a single atomic load
+         *
+         * @return Ptr Never null, version 0 until the first order
+         */
+        Ptr load() const { return orders_.load(); }
+
+        /**
+         * @brief Current version
+         *
+         * @return std::uint64_t Number of orders received
+         */
+        std::uint64_t version() const { return orders_.load()->version; }
+
+        /**
+         * @brief Append an order and wake the waiting readers
+         *
+         * @param order Order received
+         * @return Ptr The view that holds it
+         */
+        Ptr add(Order order);
+
+        /**
+         * @brief Wait for a view newer than a version
+         *
+         * @param version Version the caller already has
+         * @param deadline Time after which the wait gives up
+         * @return Ptr The current view, its version equals the one given if nothing arrived before the deadline
+         */
+        Ptr waitForChange(std::uint64_t version, const ros::Time& deadline) const;
+
+        private:
+        Snapshot<Orders> orders_;
+        mutable std::mutex mutex_;
+        mutable std::condition_variable changed_;
+    };
+}  // namespace motioncontrol
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef PART_TYPE_H
+#define PART_TYPE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Part type interned as a small integer
+     *
+     * The names ("assembly_pump_blue", ...) live once in a side table and
+     * a PartType only holds their index, so comparing and hashing types
+     * are integer operations. A PartType converts to its name where a
+     * string is expected (logging, maps keyed by name). The default
+     * value is the empty type.
+     */
+    class PartType {
+        public:
+        /// Most distinct types the table holds, later names map to the empty type
+        static constexpr std::size_t kMaxTypes = 1024;
+
+        PartType() = default;
+
+        /**
+         * @brief Intern a type name
+         *
+         * @param name Type name, the empty name gives the empty type
+         */
+        PartType(const std::string& name);
+        PartType(const char* name) : PartType(std::string(name)) {}
+
+        /**
+         * @brief Name of the type
+         *
+         * @return const std::string& Valid for the whole run
+         */
+        const std::string& name() const;
+        operator const std::string&() const { return name(); }
+
+        std::uint16_t id() const { return id_; }
+        bool empty() const { return id_ == 0; }
+
+        friend bool operator==(PartType a, PartType b) { return a.id_ == b.id_; }
+        friend bool operator!=(PartType a, PartType b) { return a.id_ != b.id_; }
+        friend bool operator<(PartType a, PartType b) { return a.id_ < b.id_; }
+
+        private:
+        std::uint16_t id_{0};
+    };
+
+    /**
+     * @brief Status of a detected part
+     */
+    enum class PartStatus : std::uint8_t {
+        kFree,       // can be picked
+        kProcessed,  // picked by the control loop
+    };
+
+    inline std::ostream& operator<<(std::ostream& out, PartType type)
+    {
+        return out << type.name();
+    }
+}  // namespace motioncontrol
+
+namespace std {
+    template <>
+    struct hash<motioncontrol::PartType> {
+        std::size_t operator()(motioncontrol::PartType type) const { return type.id(); }
+    };
+}  // namespace std
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef POINT_BATCH_H
+#define POINT_BATCH_H
+
+#include <vector>
+#include <geometry_msgs/Point32.h>
+#include <tf2/LinearMath/Transform.h>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Structure-of-arrays storage for the points of a cloud
+     *
+     * One array per coordinate, in single precision like the depth camera
+     * data, so the transform loop vectorizes over many points at once. Storage is
+     * only grown, never shrunk, so a reused batch does not allocate once it
+     * has seen its largest cloud.
+     */
+    class PointBatch {
+        public:
+        /**
+         * @brief Set the number of points, keeping the allocated capacity
+         *
+         * @param n Number of points
+         */
+        void resize(std::size_t n);
+
+        /**
+         * @brief Number of points in the batch
+         *
+         * @return std::size_t
+         */
+        std::size_t size() const { return size_; }
+
+        /**
+         * @brief Fill the batch with the points of a cloud
+         *
+         * @param points Points of a sensor_msgs::PointCloud, may hold NaN where the camera got no return
+         */
+        void assign(const std::vector<geometry_msgs::Point32>& points);
+
+        // components, valid up to size()
+        std::vector<float> x, y, z;
+
+        private:
+        std::size_t size_{0};
+    };
+
+    /**
+     * @brief Apply one rigid transform to every point of a batch
+     *
+     * out_i = frame_in_world * in_i. in and out must be different batches.
+     *
+     * @param frame_in_world Pose of the batch frame in the world frame
+     * @param in Points in the batch frame
+     * @param out Filled with the points in the world frame
+     */
+    void transformPoints(const tf2::Transform& frame_in_world, const PointBatch& in, PointBatch& out);
+}  // namespace motioncontrol
+
+#endif
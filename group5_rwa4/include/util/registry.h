@@ -0,0 +1,256 @@
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Sensors of the workcell
+     *
+     * The logical cameras come first, in the order of
+     * WorldModel::parts, followed by the quality control
+     * sensors. To add a sensor, add it here and in Registry::sensors at the
+     * same position.
+     */
+    enum class SensorId : std::uint8_t {
+        kBins0,
+        kBins1,
+        kStation1,
+        kStation2,
+        kStation3,
+        kStation4,
+        kAgv1As1,
+        kAgv1As2,
+        kAgv1Ks,
+        kAgv2As1,
+        kAgv2As2,
+        kAgv2Ks,
+        kAgv3As3,
+        kAgv3As4,
+        kAgv3Ks,
+        kAgv4As3,
+        kAgv4As4,
+        kAgv4Ks,
+        kBelt,
+        kQualityControl1,
+        kQualityControl2,
+        kQualityControl3,
+        kQualityControl4,
+        kCount
+    };
+
+    /// Number of sensors in the registry
+    constexpr std::size_t kSensorCount = static_cast<std::size_t>(SensorId::kCount);
+    /// Number of logical cameras, they are the first entries of the registry
+    constexpr std::size_t kLogicalCameraCount = static_cast<std::size_t>(SensorId::kQualityControl1);
+    /// Number of quality control sensors
+    constexpr std::size_t kQualityControlCount = kSensorCount - kLogicalCameraCount;
+    /// Topic of the conveyor breakbeam, one message per change so each crossing is reported once
+    constexpr const char* kBreakbeamTopic = "/ariac/breakbeam_0_change";
+
+    /**
+     * @brief Static description of a sensor
+     */
+    struct SensorInfo {
+        SensorId id;
+        const char* name;   // sensor name in the user config (e.g., "logical_camera_bins0")
+        const char* topic;  // topic of the images
+        const char* frame;  // TF frame of the sensor
+        const char* agv;    // AGV watched by a quality control sensor, empty otherwise
+        bool scanned;       // subscribed when scanning the workcell
+        int first_bin;      // first of the four bins watched by a bin camera, 0 otherwise
+        int bin_side;       // sign of y for the bins watched by a bin camera, 0 otherwise
+    };
+
+    /**
+     * @brief Kit trays on the AGVs and briefcases at the assembly stations
+     */
+    enum class TrayId : std::uint8_t {
+        kAgv1,
+        kAgv2,
+        kAgv3,
+        kAgv4,
+        kAs1,
+        kAs2,
+        kAs3,
+        kAs4,
+        kCount
+    };
+
+    /// Number of trays in the registry
+    constexpr std::size_t kTrayCount = static_cast<std::size_t>(TrayId::kCount);
+
+    /**
+     * @brief Static description of a tray
+     */
+    struct TrayInfo {
+        TrayId id;
+        const char* location;  // location used in orders ("agv1", "as1", ...)
+        const char* frame;     // TF frame of the tray
+        bool moves;            // the tray rides on an AGV
+    };
+
+    /**
+     * @brief Preset joint positions of the kitting arm
+     */
+    enum class ArmPreset : std::uint8_t {
+        kHome1,
+        kHome2,
+        kOn,
+        kAbove,
+        kAgv1,
+        kAgv2,
+        kAgv3,
+        kAgv4,
+        kFlip,
+        kCount
+    };
+
+    /// Number of kitting arm presets
+    constexpr std::size_t kArmPresetCount = static_cast<std::size_t>(ArmPreset::kCount);
+    /// Joints of the kitting arm, linear actuator first
+    constexpr std::size_t kArmJointCount = 7;
+
+    /**
+     * @brief Static description of a kitting arm preset
+     */
+    struct ArmPresetInfo {
+        ArmPreset id;
+        const char* name;
+        std::array<double, kArmJointCount> joints;
+    };
+
+    /**
+     * @brief Compile-time tables indexed by the enums above
+     *
+     * The tables are defined in registry.cpp.
+     */
+    struct Registry {
+        static constexpr SensorInfo sensors[kSensorCount] = {
+            { SensorId::kBins0, "logical_camera_bins0", "/ariac/logical_camera_bins0", "logical_camera_bins0_frame", "", true, 1, 1 },
+            { SensorId::kBins1, "logical_camera_bins1", "/ariac/logical_camera_bins1", "logical_camera_bins1_frame", "", true, 5, -1 },
+            { SensorId::kStation1, "logical_camera_station1", "/ariac/logical_camera_station1", "logical_camera_station1_frame", "", false, 0, 0 },
+            { SensorId::kStation2, "logical_camera_station2", "/ariac/logical_camera_station2", "logical_camera_station2_frame", "", false, 0, 0 },
+            { SensorId::kStation3, "logical_camera_station3", "/ariac/logical_camera_station3", "logical_camera_station3_frame", "", false, 0, 0 },
+            { SensorId::kStation4, "logical_camera_station4", "/ariac/logical_camera_station4", "logical_camera_station4_frame", "", false, 0, 0 },
+            { SensorId::kAgv1As1, "logical_camera_agv1as1", "/ariac/logical_camera_agv1as1", "logical_camera_agv1as1_frame", "", true, 0, 0 },
+            { SensorId::kAgv1As2, "logical_camera_agv1as2", "/ariac/logical_camera_agv1as2", "logical_camera_agv1as2_frame", "", true, 0, 0 },
+            { SensorId::kAgv1Ks, "logical_camera_agv1ks", "/ariac/logical_camera_agv1ks", "logical_camera_agv1ks_frame", "", false, 0, 0 },
+            { SensorId::kAgv2As1, "logical_camera_agv2as1", "/ariac/logical_camera_agv2as1", "logical_camera_agv2as1_frame", "", true, 0, 0 },
+            { SensorId::kAgv2As2, "logical_camera_agv2as2", "/ariac/logical_camera_agv2as2", "logical_camera_agv2as2_frame", "", true, 0, 0 },
+            { SensorId::kAgv2Ks, "logical_camera_agv2ks", "/ariac/logical_camera_agv2ks", "logical_camera_agv2ks_frame", "", false, 0, 0 },
+            { SensorId::kAgv3As3, "logical_camera_agv3as3", "/ariac/logical_camera_agv3as3", "logical_camera_agv3as3_frame", "", true, 0, 0 },
+            { SensorId::kAgv3As4, "logical_camera_agv3as4", "/ariac/logical_camera_agv3as4", "logical_camera_agv3as4_frame", "", true, 0, 0 },
+            { SensorId::kAgv3Ks, "logical_camera_agv3ks", "/ariac/logical_camera_agv3ks", "logical_camera_agv3ks_frame", "", false, 0, 0 },
+            { SensorId::kAgv4As3, "logical_camera_agv4as3", "/ariac/logical_camera_agv4as3", "logical_camera_agv4as3_frame", "", true, 0, 0 },
+            { SensorId::kAgv4As4, "logical_camera_agv4as4", "/ariac/logical_camera_agv4as4", "logical_camera_agv4as4_frame", "", true, 0, 0 },
+            { SensorId::kAgv4Ks, "logical_camera_agv4ks", "/ariac/logical_camera_agv4ks", "logical_camera_agv4ks_frame", "", false, 0, 0 },
+            { SensorId::kBelt, "logical_camera_belt", "/ariac/logical_camera_belt", "logical_camera_belt_frame", "", false, 0, 0 },
+            { SensorId::kQualityControl1, "quality_control_sensor_1", "/ariac/quality_control_sensor_1", "quality_control_sensor_1_frame", "agv1", true, 0, 0 },
+            { SensorId::kQualityControl2, "quality_control_sensor_2", "/ariac/quality_control_sensor_2", "quality_control_sensor_2_frame", "agv2", true, 0, 0 },
+            { SensorId::kQualityControl3, "quality_control_sensor_3", "/ariac/quality_control_sensor_3", "quality_control_sensor_3_frame", "agv3", true, 0, 0 },
+            { SensorId::kQualityControl4, "quality_control_sensor_4", "/ariac/quality_control_sensor_4", "quality_control_sensor_4_frame", "agv4", true, 0, 0 },
+        };
+
+        static constexpr TrayInfo trays[kTrayCount] = {
+            { TrayId::kAgv1, "agv1", "kit_tray_1", true },
+            { TrayId::kAgv2, "agv2", "kit_tray_2", true },
+            { TrayId::kAgv3, "agv3", "kit_tray_3", true },
+            { TrayId::kAgv4, "agv4", "kit_tray_4", true },
+            { TrayId::kAs1, "as1", "briefcase_1", false },
+            { TrayId::kAs2, "as2", "briefcase_2", false },
+            { TrayId::kAs3, "as3", "briefcase_3", false },
+            { TrayId::kAs4, "as4", "briefcase_4", false },
+        };
+
+        static constexpr ArmPresetInfo arm_presets[kArmPresetCount] = {
+            { ArmPreset::kHome1, "home1", {{ 0, 0, -1.25, 1.74, -2.04, -1.57, 0 }} },
+            { ArmPreset::kHome2, "home2", {{ 0, -M_PI, -1.25, 1.74, -2.04, -1.57, 0 }} },
+            { ArmPreset::kOn, "on", {{ 1.76, 0, -0.74, 1.76, 5.28, 0, 0 }} },
+            { ArmPreset::kAbove, "above", {{ 1.76, 0, -1.62, 1.76, 6.28, 0, 0.0 }} },
+            { ArmPreset::kAgv1, "agv1", {{ 3.83, -M_PI, -1.25, 1.74, -2.04, -1.57, 0 }} },
+            { ArmPreset::kAgv2, "agv2", {{ 0.83, -M_PI, -1.25, 1.74, -2.04, -1.57, 0 }} },
+            { ArmPreset::kAgv3, "agv3", {{ -1.83, -M_PI, -1.25, 1.74, -2.04, -1.57, 0 }} },
+            { ArmPreset::kAgv4, "agv4", {{ -4.33, -M_PI, -1.25, 1.74, -2.04, -1.57, 0 }} },
+            { ArmPreset::kFlip, "flip", {{ -3.97, 0, -2.54, -2.0, 4.56, 0, 0 }} },
+        };
+    };
+
+    constexpr std::size_t index(SensorId id) { return static_cast<std::size_t>(id); }
+    constexpr std::size_t index(TrayId id) { return static_cast<std::size_t>(id); }
+    constexpr std::size_t index(ArmPreset id) { return static_cast<std::size_t>(id); }
+
+    constexpr const SensorInfo& sensorInfo(SensorId id) { return Registry::sensors[index(id)]; }
+    constexpr const TrayInfo& trayInfo(TrayId id) { return Registry::trays[index(id)]; }
+    constexpr const ArmPresetInfo& armPresetInfo(ArmPreset id) { return Registry::arm_presets[index(id)]; }
+
+    /// Logical camera with a given index in WorldModel::parts
+    constexpr SensorId cameraAt(std::size_t i) { return static_cast<SensorId>(i); }
+    /// Quality control sensor n, from 0
+    constexpr SensorId qualityControlAt(std::size_t n) { return static_cast<SensorId>(kLogicalCameraCount + n); }
+
+    namespace detail {
+        constexpr bool sensorsInOrder()
+        {
+            for (std::size_t i = 0; i < kSensorCount; i++)
+                if (index(Registry::sensors[i].id) != i)
+                    return false;
+            return true;
+        }
+        constexpr bool traysInOrder()
+        {
+            for (std::size_t i = 0; i < kTrayCount; i++)
+                if (index(Registry::trays[i].id) != i)
+                    return false;
+            return true;
+        }
+        constexpr bool armPresetsInOrder()
+        {
+            for (std::size_t i = 0; i < kArmPresetCount; i++)
+                if (index(Registry::arm_presets[i].id) != i)
+                    return false;
+            return true;
+        }
+    }  // namespace detail
+
+    static_assert(detail::sensorsInOrder(), "Registry::sensors must follow the order of SensorId");
+    static_assert(detail::traysInOrder(), "Registry::trays must follow the order of TrayId");
+    static_assert(detail::armPresetsInOrder(), "Registry::arm_presets must follow the order of ArmPreset");
+
+    /**
+     * @brief Find a sensor by name, for names coming from strings (config, orders)
+     *
+     * @param name Sensor name (e.g., "logical_camera_bins0")
+     * @param id Filled with the sensor
+     * @return true Sensor found
+     * @return false Unknown name
+     */
+    bool sensorFromName(const std::string& name, SensorId& id);
+
+    /**
+     * @brief Find a tray by location
+     *
+     * @param location "agv1".."agv4" or "as1".."as4"
+     * @param id Filled with the tray
+     * @return true Tray found
+     * @return false Unknown location
+     */
+    bool trayFromLocation(const std::string& location, TrayId& id);
+
+    /**
+     * @brief Find a kitting arm preset by name
+     *
+     * @param name Preset name (e.g., "home2", "agv1")
+     * @param id Filled with the preset
+     * @return true Preset found
+     * @return false Unknown name
+     */
+    bool armPresetFromName(const std::string& name, ArmPreset& id);
+}  // namespace motioncontrol
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef SCRATCH_FRAMES_H
+#define SCRATCH_FRAMES_H
+
+#include <array>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <ros/ros.h>
+#include <geometry_msgs/Pose.h>
+#include <geometry_msgs/TransformStamped.h>
+#include <tf2_ros/static_transform_broadcaster.h>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Bounded pool of static TF frames used to resolve poses in the world frame
+     *
+     * A pose expressed in a moving frame (kit tray, briefcase) is resolved by
+     * broadcasting it as a static child frame and looking that child up in
+     * the world frame. /tf_static is latched and never forgets a child, so a
+     * new name per call grows the static tree for the whole trial. The pool
+     * reuses a fixed set of names instead: a re-sent child replaces the
+     * previous one, so at most kPoolSize scratch frames ever exist. A frame
+     * is held by one caller from broadcast to lookup, and the lookup only
+     * returns once the buffer holds the transform that caller sent.
+     */
+    class ScratchFrames {
+        public:
+        /// Number of scratch frames, bounds the static frames added by the node
+        static constexpr std::size_t kPoolSize = 4;
+
+        /**
+         * @brief Access the shared instance
+         *
+         * The instance is created on first use, so this must not be called
+         * before ros::init().
+         *
+         * @return ScratchFrames&
+         */
+        static ScratchFrames& instance();
+
+        /**
+         * @brief Publish the number of live scratch frames
+         *
+         * The count is latched and republished whenever it changes.
+         *
+         * @param node Node handle used to advertise the topic
+         * @param topic Topic name (std_msgs/UInt32)
+         */
+        void advertise(ros::NodeHandle& node, const std::string& topic);
+
+        /**
+         * @brief Resolve a pose given in a parent frame in the world frame
+         *
+         * Waits while all the scratch frames are in use by other callers.
+         *
+         * @param parent Frame the pose is expressed in (e.g., "kit_tray_1")
+         * @param pose Pose in the parent frame
+         * @param deadline Time after which the lookup gives up, waiting for a
+         * free frame included
+         * @param world_pose Filled with the pose in the world frame
+         * @return true Pose resolved
+         * @return false The frame could not be looked up before the deadline
+         */
+        bool toWorld(const std::string& parent, const geometry_msgs::Pose& pose,
+            const ros::Time& deadline, geometry_msgs::Pose& world_pose);
+
+        /**
+         * @brief Number of scratch frames broadcast so far
+         *
+         * @return std::size_t Never more than kPoolSize
+         */
+        std::size_t liveFrames() const;
+
+        ScratchFrames(const ScratchFrames&) = delete;
+        ScratchFrames& operator=(const ScratchFrames&) = delete;
+
+        private:
+        ScratchFrames() = default;
+        bool acquire(const ros::Time& deadline, std::size_t& slot);
+        void release(std::size_t slot);
+        void publishLiveFrames();
+
+        mutable std::mutex mutex_;
+        std::condition_variable available_;
+        std::array<bool, kPoolSize> in_use_{};
+        std::array<bool, kPoolSize> broadcast_{};
+        std::size_t live_frames_{0};
+        tf2_ros::StaticTransformBroadcaster broadcaster_;
+        ros::Publisher live_frames_pub_;
+    };
+}  // namespace motioncontrol
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef SENSOR_HEALTH_H
+#define SENSOR_HEALTH_H
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <ros/ros.h>
+#include "registry.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Change of the sensor health reported by SensorHealth
+     */
+    struct HealthEvent {
+        enum class Type { kSensorDown, kSensorUp, kBlackoutStarted, kBlackoutEnded };
+        Type type;
+        SensorId sensor;  // sensor that went down or up, unused for blackouts
+        ros::Time stamp;
+    };
+
+    /**
+     * @brief Last-seen time and rate of every sensor of the registry
+     *
+     * Each image is reported with heartbeat(). A sensor is down once it
+     * has been silent for kSilencePeriods of its own period, and never
+     * less than kMinSilence. A blackout starts when every sensor that has
+     * reported at least once is down, and ends with the first image that
+     * arrives afterwards. Sensors are checked by a timer started with
+     * start().
+     */
+    class SensorHealth {
+        public:
+        /// Periods without an image before a sensor is down
+        static constexpr double kSilencePeriods = 5.0;
+        /// Shortest silence before a sensor is down, in seconds
+        static constexpr double kMinSilence = 0.5;
+        /// Period of the health check, in seconds
+        static constexpr double kCheckPeriod = 0.1;
+        /// Events kept until takeEvents() is called, older ones are dropped; kitting takes them before every pick
+        static constexpr std::size_t kMaxEvents = 256;
+
+        /**
+         * @brief Access the shared instance
+         *
+         * @return SensorHealth&
+         */
+        static SensorHealth& instance();
+
+        /**
+         * @brief Start the periodic health check
+         *
+         * @param node Node handle used to create the timer
+         */
+        void start(ros::NodeHandle& node);
+
+        /**
+         * @brief Record an image of a sensor
+         *
+         * @param sensor Sensor that published
+         */
+        void heartbeat(SensorId sensor);
+
+        /**
+         * @brief Whether all the sensors are silent
+         *
+         * @return true Sensor blackout in progress
+         * @return false Sensors are reporting
+         */
+        bool blackout() const;
+
+        /**
+         * @brief Whether a sensor is reporting
+         *
+         * @param sensor Sensor
+         * @return true The sensor reported within its silence limit
+         * @return false Silent or never seen
+         */
+        bool alive(SensorId sensor) const;
+
+        /**
+         * @brief Time of the latest image of a sensor
+         *
+         * @param sensor Sensor
+         * @return ros::Time Zero if the sensor has not reported yet
+         */
+        ros::Time lastSeen(SensorId sensor) const;
+
+        /**
+         * @brief Estimated image rate of a sensor
+         *
+         * @param sensor Sensor
+         * @return double Images per second, 0 until two images were seen
+         */
+        double rate(SensorId sensor) const;
+
+        /**
+         * @brief Wait for the end of a blackout
+         *
+         * @param deadline Time after which the wait gives up
+         * @return true No blackout
+         * @return false Still in blackout at the deadline
+         */
+        bool waitForSensors(const ros::Time& deadline) const;
+
+        /**
+         * @brief Events since the previous call, oldest first
+         *
+         * @return std::vector<HealthEvent>
+         */
+        std::vector<HealthEvent> takeEvents();
+
+        SensorHealth(const SensorHealth&) = delete;
+        SensorHealth& operator=(const SensorHealth&) = delete;
+
+        private:
+        SensorHealth() = default;
+        void check(const ros::TimerEvent& event);
+        void emit(HealthEvent::Type type, SensorId sensor, const ros::Time& stamp);
+        double silenceLimit(std::size_t i) const;
+
+        mutable std::mutex mutex_;
+        mutable std::condition_variable changed_;
+        std::array<ros::Time, kSensorCount> last_seen_;
+        std::array<double, kSensorCount> period_{};  // smoothed time between images, in seconds
+        std::array<bool, kSensorCount> alive_{};
+        bool blackout_{false};
+        std::deque<HealthEvent> events_;
+        ros::Timer timer_;
+    };
+}  // namespace motioncontrol
+
+#endif
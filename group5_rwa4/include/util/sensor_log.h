@@ -0,0 +1,246 @@
+#ifndef SENSOR_LOG_H
+#define SENSOR_LOG_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+#include <ros/serialization.h>
+#include <geometry_msgs/TransformStamped.h>
+#include <nist_gear/LogicalCameraImage.h>
+#include <nist_gear/Order.h>
+#include <nist_gear/Proximity.h>
+#include <nist_gear/VacuumGripperState.h>
+#include <sensor_msgs/LaserScan.h>
+#include "registry.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Kinds of messages in a sensor log
+     */
+    enum class RecordKind : std::uint16_t {
+        kTransform,      // pose of a sensor frame in the world frame
+        kLogicalCamera,  // source is the SensorId
+        kBreakbeam,
+        kLaserScan,
+        kOrder,
+        kGripperState,   // source is 0 for the kitting arm, 1 for the gantry
+        kCount
+    };
+
+    /// Number of record kinds
+    constexpr std::size_t kRecordKindCount = static_cast<std::size_t>(RecordKind::kCount);
+
+    /**
+     * @brief Layout of a sensor log file
+     *
+     * A 16 byte file header (kMagic then the format version) followed by
+     * records. A record is a RecordHeader and the ROS serialization of the
+     * message, padded to 8 bytes so every header is aligned in a mapping
+     * of the file. Records are only ever appended, a record cut short by a
+     * crash ends the log.
+     */
+    struct SensorLogFormat {
+        static constexpr char kMagic[8] = { 'G', '5', 'S', 'L', 'O', 'G', '\0', '\0' };
+        static constexpr std::uint32_t kVersion = 1;
+        static constexpr std::size_t kFileHeaderSize = 16;
+        static constexpr std::size_t kAlignment = 8;
+
+        struct RecordHeader {
+            std::uint32_t size;    // bytes of the message, without padding
+            std::uint16_t kind;    // RecordKind
+            std::uint16_t source;  // sensor or arm, depends on the kind
+            std::uint32_t sec;     // ROS time the message was received
+            std::uint32_t nsec;
+        };
+        static_assert(sizeof(RecordHeader) == 16, "RecordHeader must keep records aligned");
+
+        static std::size_t padded(std::size_t size) { return (size + kAlignment - 1) / kAlignment * kAlignment; }
+    };
+
+    /**
+     * @brief Writes the sensor traffic of the node to a sensor log
+     *
+     * Subscribes on its own to the topics the perception and decision
+     * callbacks listen to, and appends each message with its receipt
+     * time. The world poses of the sensor frames are written first so the
+     * log replays without TF. Writes are buffered, the file is complete
+     * once stop() returns.
+     */
+    class SensorRecorder {
+        public:
+        /**
+         * @brief Access the shared instance
+         *
+         * @return SensorRecorder&
+         */
+        static SensorRecorder& instance();
+
+        /**
+         * @brief Open a log and start recording
+         *
+         * An existing file is replaced.
+         *
+         * @param node Node handle used for the subscriptions
+         * @param path Path of the log
+         * @return true Recording
+         * @return false The file cannot be opened, or a recording is running
+         */
+        bool start(ros::NodeHandle& node, const std::string& path);
+
+        /**
+         * @brief Stop recording and close the log
+         */
+        void stop();
+
+        /**
+         * @brief Append one message
+         *
+         * @param kind Kind of the message
+         * @param source Sensor or arm, see RecordKind
+         * @param stamp Time the message was received
+         * @param msg Message
+         */
+        template <class M>
+        void write(RecordKind kind, std::uint16_t source, const ros::Time& stamp, const M& msg)
+        {
+            const std::uint32_t size = ros::serialization::serializationLength(msg);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!file_)
+                return;
+            buffer_.assign(SensorLogFormat::padded(size), 0);
+            ros::serialization::OStream stream(buffer_.data(), size);
+            ros::serialization::serialize(stream, msg);
+            append(kind, source, stamp, size);
+        }
+
+        /**
+         * @brief Records written since start()
+         *
+         * @return std::uint64_t
+         */
+        std::uint64_t records() const;
+
+        ~SensorRecorder();
+
+        private:
+        SensorRecorder() = default;
+        void append(RecordKind kind, std::uint16_t source, const ros::Time& stamp, std::uint32_t size);
+        void writeTransform(const std::string& frame);
+
+        mutable std::mutex mutex_;
+        std::FILE* file_{nullptr};
+        std::vector<std::uint8_t> buffer_;
+        std::uint64_t records_{0};
+        std::vector<ros::Subscriber> subscribers_;
+        // frames whose pose is in the log
+        std::set<std::string> frames_;
+    };
+
+    /**
+     * @brief Read access to a sensor log, mapped in memory
+     */
+    class SensorLog {
+        public:
+        /**
+         * @brief One message of the log, pointing into the mapping
+         */
+        struct Record {
+            RecordKind kind;
+            std::uint16_t source;
+            ros::Time stamp;
+            const std::uint8_t* data;
+            std::uint32_t size;
+
+            /**
+             * @brief Deserialize the message
+             *
+             * @param msg Filled with the message, its type must match the kind
+             */
+            template <class M>
+            void read(M& msg) const
+            {
+                ros::serialization::IStream stream(const_cast<std::uint8_t*>(data), size);
+                ros::serialization::deserialize(stream, msg);
+            }
+        };
+
+        SensorLog() = default;
+        ~SensorLog();
+        SensorLog(const SensorLog&) = delete;
+        SensorLog& operator=(const SensorLog&) = delete;
+
+        /**
+         * @brief Map a log and index its records
+         *
+         * @param path Path of the log
+         * @return true The log is mapped, a truncated last record is left out
+         * @return false The file cannot be read or is not a sensor log
+         */
+        bool open(const std::string& path);
+
+        /**
+         * @brief Records in the order they were written
+         *
+         * @return const std::vector<Record>&
+         */
+        const std::vector<Record>& records() const { return records_; }
+
+        private:
+        void close();
+
+        void* map_{nullptr};
+        std::size_t length_{0};
+        std::vector<Record> records_;
+    };
+
+    /**
+     * @brief Pushes the messages of a sensor log through the node callbacks
+     *
+     * The ROS clock is set to the receipt time of each message before its
+     * callback runs, so the callbacks see the times of the recording and a
+     * replay gives the same result every time. Transforms go straight to
+     * the buffer of TransformService.
+     */
+    class SensorReplayer {
+        public:
+        /**
+         * @brief Callbacks fed by the replay, unset ones are skipped
+         */
+        struct Handlers {
+            std::function<void(SensorId, const nist_gear::LogicalCameraImage::ConstPtr&)> logical_camera;
+            std::function<void(const nist_gear::Proximity::ConstPtr&)> breakbeam;
+            std::function<void(const sensor_msgs::LaserScan::ConstPtr&)> laser_scan;
+            std::function<void(const nist_gear::Order::ConstPtr&)> order;
+            std::function<void(std::uint16_t, const nist_gear::VacuumGripperState::ConstPtr&)> gripper_state;
+        };
+
+        /**
+         * @brief Outcome of a replay
+         */
+        struct Stats {
+            std::array<std::size_t, kRecordKindCount> records{};
+            double log_seconds{0};   // ROS time covered by the log
+            double wall_seconds{0};  // time the replay took
+        };
+
+        /**
+         * @brief Replay a log
+         *
+         * @param log Mapped log
+         * @param speed Multiple of the recorded rate, 0 replays as fast as the callbacks go
+         * @param handlers Callbacks
+         * @return Stats
+         */
+        static Stats replay(const SensorLog& log, double speed, const Handlers& handlers);
+    };
+}  // namespace motioncontrol
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <ros/ros.h>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Waits bounded by the competition clock
+     *
+     * Deadlines are ROS times, which follow /clock under Gazebo, so a wait
+     * lasts the same simulated time whether Gazebo runs slower or faster
+     * than real time. Each /clock message is passed to tick(), which wakes
+     * the waits whose deadline it reaches. A wait on a condition also
+     * wakes as soon as the condition variable it is given is notified, so
+     * it ends with the event instead of at a fixed period.
+     * A tick landing between a check and the wait is noticed within
+     * kTickedSlice.
+     *
+     * Without /clock (wall time, or an offline replay that sets the time
+     * itself) the deadlines are checked every kPolledSlice instead.
+     * Periodic work keeps using ros::Timer, which already runs on the ROS
+     * clock.
+     */
+    class SimClock {
+        public:
+        /// Longest wall time between two checks of a wait while /clock is published, in seconds
+        static constexpr double kTickedSlice = 0.1;
+        /// Longest wall time between two checks of a wait without /clock, in seconds
+        static constexpr double kPolledSlice = 0.01;
+
+        /**
+         * @brief Access the shared instance
+         *
+         * @return SimClock&
+         */
+        static SimClock& instance();
+
+        /**
+         * @brief Advance the clock, called with every /clock message
+         *
+         * @param stamp Simulation time of the message
+         */
+        void tick(const ros::Time& stamp);
+
+        /**
+         * @brief Current time, never behind the latest tick
+         *
+         * @return ros::Time
+         */
+        ros::Time now() const;
+
+        /**
+         * @brief Sleep until a time
+         *
+         * @param deadline Time to wake at
+         * @return true Deadline reached
+         * @return false ROS shut down first
+         */
+        bool sleepUntil(const ros::Time& deadline);
+
+        /**
+         * @brief Sleep for a simulated duration
+         *
+         * @param duration Duration
+         * @return true Slept the whole duration
+         * @return false ROS shut down first
+         */
+        bool sleepFor(const ros::Duration& duration);
+
+        /**
+         * @brief Wait for a condition
+         *
+         * The caller holds @p lock, which guards the condition, and
+         * notifies @p cv whenever the condition may have changed.
+         *
+         * @param cv Condition variable notified by the producer
+         * @param lock Lock held on the mutex of the condition
+         * @param deadline Time after which the wait gives up
+         * @param ready Condition, evaluated with the lock held
+         * @return true Condition met
+         * @return false Not met by the deadline
+         */
+        template <class Predicate>
+        bool waitUntil(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, const ros::Time& deadline,
+            Predicate ready)
+        {
+            if (ready())
+                return true;
+            const auto waiter = enlist(deadline, cv);
+            while (!ready() && now() < deadline && ros::ok())
+                cv.wait_for(lock, slice());
+            delist(waiter);
+            return ready();
+        }
+
+        SimClock(const SimClock&) = delete;
+        SimClock& operator=(const SimClock&) = delete;
+
+        private:
+        using Waiters = std::multimap<ros::Time, std::condition_variable*>;
+
+        SimClock() = default;
+        Waiters::iterator enlist(const ros::Time& deadline, std::condition_variable& cv);
+        void delist(Waiters::iterator waiter);
+        std::chrono::milliseconds slice() const;
+
+        mutable std::mutex mutex_;
+        ros::Time last_tick_;
+        std::chrono::steady_clock::time_point last_tick_wall_;
+        // waits in progress by deadline, woken by the tick that reaches it
+        Waiters waiters_;
+    };
+}  // namespace motioncontrol
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Versioned immutable copies of a value shared between threads
+     *
+     * Writers copy the current version, modify the copy and publish it
+     * with one atomic store. Readers take the current version with one
+     * atomic load and keep it alive for as long as they hold the pointer,
+     * so a reader never waits for a writer and never sees a value being
+     * modified. Writers are serialized among themselves.
+     *
+     * @tparam T Copyable value
+     */
+    template <typename T>
+    class Snapshot {
+        public:
+        /**
+         * @brief One published version of the value
+         */
+        struct View {
+            std::uint64_t version;  // 0 for the initial value, incremented by each update
+            T value;
+        };
+        using Ptr = std::shared_ptr<const View>;
+
+        Snapshot() : current_(std::make_shared<const View>(View{ 0, T() })) {}
+
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+
+        /**
+         * @brief Current version
+         *
+         * @return Ptr Never null
+         */
+        Ptr load() const
+        {
+            return std::atomic_load(&current_);
+        }
+
+        /**
+         * @brief Publish a new version
+         *
+         * @param modify Called with a copy of the current value to turn it into the next one
+         * @return Ptr The published version
+         */
+        template <typename F>
+        Ptr update(F&& modify)
+        {
+            std::lock_guard<std::mutex> lock(writer_mutex_);
+            const Ptr previous = load();
+            auto next = std::make_shared<View>(*previous);
+            next->version = previous->version + 1;
+            std::forward<F>(modify)(next->value);
+            Ptr published = std::move(next);
+            std::atomic_store(&current_, published);
+            return published;
+        }
+
+        private:
+        Ptr current_;
+        std::mutex writer_mutex_;
+    };
+}  // namespace motioncontrol
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef TRANSFORM_SERVICE_H
+#define TRANSFORM_SERVICE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+#include <geometry_msgs/TransformStamped.h>
+#include <tf2_ros/buffer.h>
+#include <tf2_ros/transform_listener.h>
+
+namespace motioncontrol {
+
+    /**
+     * @brief Process-wide TF buffer shared by every transform helper.
+     *
+     * A tf2_ros::Buffer only becomes useful once its listener has received
+     * /tf_static and a few /tf messages. Building one per lookup means paying
+     * that subscription and wait on every call, so the node keeps a single
+     * buffer alive instead. The listener runs on its own spin thread, which
+     * keeps lookups working while the main thread or the AsyncSpinner threads
+     * are blocked. tf2_ros::Buffer is internally synchronized, so the query
+     * API can be used from any thread.
+     *
+     * Without a ROS master (offline replay) there is no listener, the
+     * buffer only holds the transforms set on it directly.
+     */
+    class TransformService {
+        public:
+        /**
+         * @brief Access the shared instance
+         *
+         * The instance is created on first use, so this must not be called
+         * before ros::init().
+         *
+         * @return TransformService&
+         */
+        static TransformService& instance();
+
+        /**
+         * @brief Wait until each frame can be resolved against the world frame
+         *
+         * @param frames Frames that should be in the buffer
+         * @param timeout Overall time allowed for all the frames
+         * @return true All the frames are available
+         * @return false At least one frame is still missing
+         */
+        bool warmup(const std::vector<std::string>& frames, const ros::Duration& timeout);
+
+        /**
+         * @brief Wait for the latest transform from source to target until a deadline
+         *
+         * Returns as soon as the transform is in the buffer, so a transform
+         * that is already available costs a single query.
+         *
+         * @param target Target frame (e.g., "world")
+         * @param source Source frame
+         * @param deadline Time after which the lookup gives up
+         * @param transform Filled with the transform on success
+         * @param waited If not null, filled with the time spent waiting
+         * @return true Transform found before the deadline
+         * @return false Transform not available by the deadline
+         */
+        bool waitForTransform(const std::string& target, const std::string& source,
+            const ros::Time& deadline, geometry_msgs::TransformStamped& transform,
+            ros::Duration* waited = nullptr) const;
+
+        /**
+         * @brief Look up the latest transform from source to target
+         *
+         * @param target Target frame (e.g., "world")
+         * @param source Source frame
+         * @param timeout Time to wait for the transform to become available
+         * @param transform Filled with the transform on success
+         * @return true Transform found
+         * @return false Transform not available within timeout
+         */
+        bool lookup(const std::string& target, const std::string& source,
+            const ros::Duration& timeout, geometry_msgs::TransformStamped& transform) const;
+
+        /**
+         * @brief Access the underlying buffer
+         *
+         * @return tf2_ros::Buffer&
+         */
+        tf2_ros::Buffer& buffer();
+
+        TransformService(const TransformService&) = delete;
+        TransformService& operator=(const TransformService&) = delete;
+
+        private:
+        TransformService();
+        tf2_ros::Buffer buffer_;
+        std::unique_ptr<tf2_ros::TransformListener> listener_;
+    };
+}  // namespace motioncontrol
+
+#endif
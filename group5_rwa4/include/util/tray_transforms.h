@@ -0,0 +1,118 @@
+#ifndef TRAY_TRANSFORMS_H
+#define TRAY_TRANSFORMS_H
+
+#include <array>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+#include <geometry_msgs/Pose.h>
+#include <tf2/LinearMath/Transform.h>
+#include "util.h"
+#include "registry.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Cached world poses of the kit trays and briefcases
+     *
+     * Every part of a shipment is placed relative to the same kit_tray_N or
+     * briefcase_N frame, so the tray pose is looked up once and reused.
+     * Briefcases are fixed to the assembly stations and are cached for the
+     * whole trial. A kit tray rides on its AGV: its entry is dropped when
+     * the AGV is shipped and when /ariac/agvN/station reports a new station,
+     * and it is not cached while the AGV is travelling.
+     */
+    class TrayTransforms {
+        public:
+        /**
+         * @brief Access the shared instance
+         *
+         * @return TrayTransforms&
+         */
+        static TrayTransforms& instance();
+
+        /**
+         * @brief Get the pose of a tray in the world frame
+         *
+         * @param tray Tray
+         * @param deadline Time after which the TF lookup gives up on a cache miss
+         * @param tray_in_world Filled with the tray pose
+         * @return true Tray pose is known
+         * @return false Transform not available by the deadline
+         */
+        bool trayInWorld(TrayId tray, const ros::Time& deadline, tf2::Transform& tray_in_world);
+
+        /**
+         * @brief Convert a pose from a tray frame to the world frame
+         *
+         * @param tray Tray
+         * @param pose_in_tray Pose in the tray frame
+         * @param deadline Time after which the TF lookup gives up on a cache miss
+         * @param world_pose Filled with the pose in the world frame
+         * @return true Conversion done
+         * @return false Tray pose is unknown
+         */
+        bool toWorld(TrayId tray, const geometry_msgs::Pose& pose_in_tray,
+            const ros::Time& deadline, geometry_msgs::Pose& world_pose);
+
+        /**
+         * @brief Compute the world placement target of every part of a shipment
+         *
+         * Fills Product::target_pose from Product::frame_pose with a single
+         * tray lookup.
+         *
+         * @param products Parts of the shipment
+         * @param location "agv1".."agv4" or "as1".."as4"
+         * @param deadline Time after which the TF lookup gives up
+         * @return true All the targets were computed
+         * @return false Unknown location or tray pose, targets are left untouched
+         */
+        bool placementTargets(std::vector<Product>& products, const std::string& location,
+            const ros::Time& deadline);
+
+        /**
+         * @brief Record the station reported by /ariac/agvN/station
+         *
+         * Drops the kit tray entry when the station changes.
+         *
+         * @param agv Kit tray of the AGV
+         * @param station Station name from the topic
+         */
+        void stationChanged(TrayId agv, const std::string& station);
+
+        /**
+         * @brief Drop the kit tray entry of an AGV that is about to move
+         *
+         * The tray is not cached again until the AGV reports a new station.
+         *
+         * @param agv Kit tray of the AGV
+         */
+        void agvShipped(TrayId agv);
+
+        /**
+         * @brief Wait for an AGV to report a station
+         *
+         * Wakes with the /ariac/agvN/station message that reports it.
+         *
+         * @param agv Kit tray of the AGV
+         * @param station Station name (e.g., "as2")
+         * @param deadline Time after which the wait gives up
+         * @return true The AGV is at the station
+         * @return false Elsewhere or still travelling at the deadline
+         */
+        bool waitForStation(TrayId agv, const std::string& station, const ros::Time& deadline);
+
+        private:
+        TrayTransforms() = default;
+        std::mutex mutex_;
+        std::array<tf2::Transform, kTrayCount> trays_;
+        std::array<bool, kTrayCount> cached_{};
+        std::array<std::string, kTrayCount> stations_;
+        std::array<bool, kTrayCount> in_transit_{};
+        std::condition_variable station_changed_;
+    };
+}  // namespace motioncontrol
+
+#endif
@@ -30,25 +30,30 @@
 #include <tf2_ros/transform_listener.h>
 #include <tf2/LinearMath/Quaternion.h>
 #include <tf2/LinearMath/Matrix3x3.h>
+#include "part_type.h"
+#include "registry.h"
 
 
+/**
+ * @brief A part seen by a camera or requested by an order
+ * 
+ * Names of types, cameras and AGVs are kept in side tables (PartType,
+ * motioncontrol::Registry), the record only holds their indices.
+ */
 typedef struct Product
 {
-    std::string type; // model type
-    geometry_msgs::Pose frame_pose; // model pose (in frame)
-    std::string frame; // model frame (e.g., "logical_camera_1_frame")
+    motioncontrol::PartType type; // model type
+    std::uint32_t id{0}; // track id given by PartTracker or BeltTracker, 0 if none
+    motioncontrol::SensorId camera{motioncontrol::SensorId::kCount}; // camera that saw the part, kCount for order parts
+    motioncontrol::TrayId faulty_agv{motioncontrol::TrayId::kCount}; // AGV watched by the quality control sensor that saw the part
+    motioncontrol::PartStatus status{motioncontrol::PartStatus::kFree};
+    std::uint8_t bin_number{0}; // bin holding the part, 0 if not in a bin
+    bool faulty{false};
+    bool processed{false};
     ros::Time time_stamp;
-    std::string id;
-    bool faulty;
+    geometry_msgs::Pose frame_pose; // model pose (in frame)
     geometry_msgs::Pose world_pose;
-    geometry_msgs::Pose target_pose;
-    geometry_msgs::TransformStamped transformStamped;
-    std::string camera;
-    std::string status;
-    bool processed;
-    std::string qcs_id;
-    int bin_number;
-    std::string faulty_cam_agv;
+    geometry_msgs::Pose target_pose; // placement target in world frame, set by TrayTransforms::placementTargets
 }   
 product;
 
@@ -100,6 +105,45 @@ order;
 
 
 namespace motioncontrol {
+    /// Overall time allowed to resolve a pose when the caller gives no deadline
+    const ros::Duration kTransformTimeout(10.0);
+    /// Time allowed for every camera of a scan to deliver a new image
+    const ros::Duration kScanTimeout(1.0);
+    /// Time allowed for a quality control sensor to report on a placed part
+    const ros::Duration kFaultTimeout(2.0);
+    /// Time allowed for the sensors to come back before the parts placed during a blackout are checked
+    const ros::Duration kBlackoutWait(10.0);
+    /// Time allowed for a part on the conveyor belt to be predicted at the pick zone
+    const ros::Duration kBeltTimeout(15.0);
+    /// Time after the predicted arrival of a belt part before it is given up
+    const ros::Duration kInterceptSlack(1.0);
+
+    /**
+     * @brief Convert a pose given in a kit tray or briefcase frame to the world frame
+     *
+     * @param target Pose in the tray frame
+     * @param agv Location of the tray ("agv1".."agv4", "as1".."as4")
+     * @param deadline Time after which the lookup gives up
+     * @param world_pose Filled with the pose in the world frame
+     * @return true Pose resolved
+     * @return false Transform not available by the deadline
+     */
+    bool transformtoWorldFrame(const geometry_msgs::Pose& target, std::string agv,
+        const ros::Time& deadline, geometry_msgs::Pose& world_pose);
+
+    /**
+     * @brief Convert a pose given in a kit tray or sensor frame to the world frame
+     *
+     * @param target Pose in the frame
+     * @param frame "agv1".."agv4" or a sensor name (e.g., "logical_camera_bins0")
+     * @param deadline Time after which the lookup gives up
+     * @param world_pose Filled with the pose in the world frame
+     * @return true Pose resolved
+     * @return false Transform not available by the deadline
+     */
+    bool gettransforminWorldFrame(const geometry_msgs::Pose& target, std::string frame,
+        const ros::Time& deadline, geometry_msgs::Pose& world_pose);
+
     geometry_msgs::Pose transformtoWorldFrame(const geometry_msgs::Pose& target,std::string agv);
     geometry_msgs::Pose gettransforminWorldFrame(const geometry_msgs::Pose& target,std::string frame);
     geometry_msgs::Pose transformToWorldFrame(std::string part_in_camera_frame);
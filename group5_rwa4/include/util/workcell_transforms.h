@@ -0,0 +1,90 @@
+#ifndef WORKCELL_TRANSFORMS_H
+#define WORKCELL_TRANSFORMS_H
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+#include <geometry_msgs/Pose.h>
+#include <nist_gear/LogicalCameraImage.h>
+#include <tf2/LinearMath/Transform.h>
+#include "registry.h"
+
+namespace motioncontrol {
+
+    /**
+     * @brief Poses of the fixed workcell sensors in the world frame
+     *
+     * Logical cameras and quality control sensors never move, so a model
+     * pose reported in a sensor frame can be converted to the world frame
+     * with one transform product. The sensor poses are read once from the
+     * user config (sensors/<name>/pose/{xyz,rpy}) on the parameter server.
+     * A sensor missing from the config is resolved once through TF
+     * (<name>_frame) and cached. Poses are stored by SensorId, so a lookup
+     * is a single array index.
+     */
+    class WorkcellTransforms {
+        public:
+        /**
+         * @brief Access the shared instance
+         *
+         * @return WorkcellTransforms&
+         */
+        static WorkcellTransforms& instance();
+
+        /**
+         * @brief Load the sensor poses from the parameter server
+         *
+         * @param node Node handle used to read the parameters
+         * @param param Name of the "sensors" map from the user config
+         * @return true At least one sensor pose was loaded
+         * @return false The parameter is missing or malformed
+         */
+        bool load(const ros::NodeHandle& node, const std::string& param);
+
+        /**
+         * @brief Get the pose of a sensor in the world frame
+         *
+         * @param sensor Sensor
+         * @param sensor_in_world Filled with the sensor pose
+         * @return true Sensor pose is known
+         * @return false Sensor is neither in the config nor in TF
+         */
+        bool sensorInWorld(SensorId sensor, tf2::Transform& sensor_in_world);
+
+        /**
+         * @brief Convert a pose from a sensor frame to the world frame
+         *
+         * @param sensor Sensor
+         * @param pose_in_sensor Pose reported by the sensor
+         * @param world_pose Filled with the pose in the world frame
+         * @return true Conversion done
+         * @return false Sensor pose is unknown
+         */
+        bool toWorld(SensorId sensor, const geometry_msgs::Pose& pose_in_sensor,
+            geometry_msgs::Pose& world_pose);
+
+        private:
+        WorkcellTransforms() = default;
+        std::mutex mutex_;
+        std::array<tf2::Transform, kSensorCount> sensors_;
+        std::array<bool, kSensorCount> known_{};
+    };
+
+    /**
+     * @brief Convert all the models of a camera image to the world frame
+     *
+     * Looks the sensor pose up once for the whole image.
+     *
+     * @param image Image published by the sensor
+     * @param sensor Sensor that published the image
+     * @param world_poses Filled with the world pose of each model, in message order
+     * @return true Converted
+     * @return false Sensor pose unknown, the image should be dropped
+     */
+    bool transformImageToWorld(const nist_gear::LogicalCameraImage& image, SensorId sensor,
+        std::vector<geometry_msgs::Pose>& world_poses);
+}  // namespace motioncontrol
+
+#endif
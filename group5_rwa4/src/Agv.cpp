@@ -1,4 +1,5 @@
 #include "../include/agv/agv.h"
+#include "../include/util/tray_transforms.h"
  
 namespace motioncontrol {
     Agv::Agv(ros::NodeHandle& node, std::string agv_name) : agv_name_{agv_name}
@@ -27,6 +28,10 @@ namespace motioncontrol {
 
 
         if (msg.response.success) {
+            // the kit tray leaves with the AGV
+            TrayId tray;
+            if (trayFromLocation(agv_name_, tray))
+                TrayTransforms::instance().agvShipped(tray);
             ROS_INFO_STREAM("[agv_control][sendAGV] AGV is taking order: " + msg.request.shipment_type);
             return true;
         }
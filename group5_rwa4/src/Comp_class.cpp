@@ -1,20 +1,29 @@
 #include "../include/comp/comp_class.h"
+#include "../include/util/registry.h"
+#include "../include/util/tray_transforms.h"
+#include "../include/camera/belt_tracker.h"
+#include "../include/camera/inventory.h"
+#include "../include/camera/depth_localizer.h"
+#include "../include/comp/order_scheduler.h"
+#include "../include/util/sim_clock.h"
 
 MyCompetitionClass::MyCompetitionClass(ros::NodeHandle & node)
   : current_score_(0)
   {
     node_ = node;
-    gantry_arm_joint_trajectory_publisher_ = node_.advertise<trajectory_msgs::JointTrajectory>(
-      "/ariac/arm1/arm/command", 10);
-
-    kitting_arm_joint_trajectory_publisher_ = node_.advertise<trajectory_msgs::JointTrajectory>(
-      "/ariac/arm2/arm/command", 10);
   }
 
 void MyCompetitionClass::init() {
     double time_called = ros::Time::now().toSec();
     competition_start_time_ = ros::Time::now().toSec();
 
+    // advertised here rather than in the constructor, which then needs no ROS master
+    gantry_arm_joint_trajectory_publisher_ = node_.advertise<trajectory_msgs::JointTrajectory>(
+      "/ariac/arm1/arm/command", 10);
+
+    kitting_arm_joint_trajectory_publisher_ = node_.advertise<trajectory_msgs::JointTrajectory>(
+      "/ariac/arm2/arm/command", 10);
+
     // subscribe to the '/ariac/competition_state' topic.
     competition_state_subscriber_ = node_.subscribe(
         "/ariac/competition_state", 10, &MyCompetitionClass::competition_state_callback, this);
@@ -33,14 +42,27 @@ void MyCompetitionClass::init() {
     "/ariac/orders", 1,
     &MyCompetitionClass::order_callback, this);
     
-    logical_camera_subscriber_ = node_.subscribe(
-    "/ariac/logical_camera_bins0", 1, 
-    &MyCompetitionClass::logical_camera_callback, this);
-    
     break_beam_subscriber_ = node_.subscribe(
-    "/ariac/breakbeam_0_change", 1, 
+    motioncontrol::kBreakbeamTopic, 10, 
     &MyCompetitionClass::breakbeam0_callback, this);
 
+    // AGV stations, used to drop cached kit tray poses when an AGV moves
+    agv1_station_subscriber_ = node_.subscribe(
+    "/ariac/agv1/station", 1,
+    &MyCompetitionClass::agv1_station_callback, this);
+
+    agv2_station_subscriber_ = node_.subscribe(
+    "/ariac/agv2/station", 1,
+    &MyCompetitionClass::agv2_station_callback, this);
+
+    agv3_station_subscriber_ = node_.subscribe(
+    "/ariac/agv3/station", 1,
+    &MyCompetitionClass::agv3_station_callback, this);
+
+    agv4_station_subscriber_ = node_.subscribe(
+    "/ariac/agv4/station", 1,
+    &MyCompetitionClass::agv4_station_callback, this);
+
     // Timer at start
     timer = node_.createTimer(ros::Duration(2), &MyCompetitionClass::callback, this);
     
@@ -70,6 +92,7 @@ void MyCompetitionClass::competition_state_callback(const std_msgs::String::Cons
 ////////////////////////
 void MyCompetitionClass::competition_clock_callback(const rosgraph_msgs::Clock::ConstPtr& msg) {
     competition_clock_ = msg->clock;
+    motioncontrol::SimClock::instance().tick(msg->clock);
 }
 
 
@@ -142,13 +165,10 @@ void MyCompetitionClass::order_callback(const nist_gear::Order::ConstPtr & order
     Order new_order;
     new_order.order_id = order_msg->order_id;
     new_order.order_processed = false;
-    new_order.priority = 1;
-    
-    if(new_order.order_id == "order_1"){
-      // order1_announced = true;
-      new_order.priority = 3;
-      ROS_INFO("High priority order is announced ");
-      high_priority_announced = true;
+    // An order announced while others are in progress preempts them
+    new_order.priority = motioncontrol::OrderScheduler::instance().announcePriority();
+    if (new_order.priority > motioncontrol::OrderScheduler::kNormalPriority){
+      ROS_INFO_STREAM("High priority order is announced: " << new_order.order_id);
     }
   
     for (const auto &kit: order_msg->kitting_shipments){
@@ -185,36 +205,53 @@ void MyCompetitionClass::order_callback(const nist_gear::Order::ConstPtr & order
         }
         new_order.assembly.push_back(new_assembly);
     }
+
+    // Tell up front which shipments the parts in the workcell can complete
+    for (const auto &shipment: motioncontrol::Inventory::instance().check(new_order)){
+      if (shipment.feasible()){
+        ROS_INFO_STREAM("[MyCompetitionClass] " << shipment.shipment_type << " can be completed");
+        continue;
+      }
+      for (const auto &missing: shipment.missing)
+        ROS_WARN_STREAM("[MyCompetitionClass] " << shipment.shipment_type << " is short of " << missing.second << " " << missing.first);
+    }
    
-    order_list_.push_back(new_order);
+    motioncontrol::OrderScheduler::instance().submit(new_order);
+    order_list_.add(std::move(new_order));
   }
 
-std::vector<Order> MyCompetitionClass::get_order_list(){
-      return order_list_;
+motioncontrol::OrderStore::Ptr MyCompetitionClass::get_orders() const{
+      return order_list_.load();
   }
 
+const motioncontrol::OrderStore& MyCompetitionClass::order_store() const{
+      return order_list_;
+  }
 
-void MyCompetitionClass::logical_camera_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-  blackout_time_ = ros::Time::now().toSec();
-}
-
-
-double MyCompetitionClass::CheckBlackout(){
-  return blackout_time_;
-}
 
 void MyCompetitionClass::breakbeam0_callback(const nist_gear::Proximity::ConstPtr & msg) 
   {
-    blackout_time_ = ros::Time::now().toSec();
     if (msg->object_detected) {  
-      parts_rolling_on_conveyor = true;
+      {
+        std::lock_guard<std::mutex> lock(conveyor_mutex_);
+        parts_rolling_on_conveyor = true;
+      }
+      conveyor_changed_.notify_all();
+      motioncontrol::BeltTracker::instance().breakbeam(msg->header.frame_id, msg->header.stamp);
     }
   }
 
 bool MyCompetitionClass::conveyor_check(){
+  std::lock_guard<std::mutex> lock(conveyor_mutex_);
   return parts_rolling_on_conveyor;
 }
 
+bool MyCompetitionClass::wait_for_conveyor(const ros::Time& deadline){
+  std::unique_lock<std::mutex> lock(conveyor_mutex_);
+  return motioncontrol::SimClock::instance().waitUntil(conveyor_changed_, lock, deadline,
+    [this](){ return parts_rolling_on_conveyor; });
+}
+
 void MyCompetitionClass::proximity_sensor0_callback(const sensor_msgs::Range::ConstPtr & msg)
 {
   if ((msg->max_range - msg->range) > 0.01){
@@ -233,24 +270,29 @@ void MyCompetitionClass::laser_profiler0_callback(const sensor_msgs::LaserScan::
   }
 }
 
+void MyCompetitionClass::depth_camera_bins1_callback(const sensor_msgs::PointCloud::ConstPtr & pc_msg)
+{
+  motioncontrol::DepthLocalizer::instance().process(*pc_msg);
+}
+
 void MyCompetitionClass::agv1_station_callback(const std_msgs::String::ConstPtr & msg)
 {
-  msg->data;
+  motioncontrol::TrayTransforms::instance().stationChanged(motioncontrol::TrayId::kAgv1, msg->data);
 }
 
 void MyCompetitionClass::agv2_station_callback(const std_msgs::String::ConstPtr & msg)
 {
-  msg->data;
+  motioncontrol::TrayTransforms::instance().stationChanged(motioncontrol::TrayId::kAgv2, msg->data);
 }
 
 void MyCompetitionClass::agv3_station_callback(const std_msgs::String::ConstPtr & msg)
 {
-  msg->data;
+  motioncontrol::TrayTransforms::instance().stationChanged(motioncontrol::TrayId::kAgv3, msg->data);
 }
 
 void MyCompetitionClass::agv4_station_callback(const std_msgs::String::ConstPtr & msg)
 {
-  msg->data;
+  motioncontrol::TrayTransforms::instance().stationChanged(motioncontrol::TrayId::kAgv4, msg->data);
 }
 
 
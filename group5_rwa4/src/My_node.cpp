@@ -27,6 +27,8 @@
 
 
 #include <algorithm>
+#include <cmath>
+#include <map>
 #include <vector>
 #include <string>
 #include <ros/ros.h>
@@ -53,8 +55,18 @@
 #include "../include/comp/comp_class.h"
 #include "../include/agv/agv.h"
 #include "../include/util/util.h"
+#include "../include/util/transform_service.h"
+#include "../include/util/workcell_transforms.h"
+#include "../include/util/scratch_frames.h"
+#include "../include/util/tray_transforms.h"
+#include "../include/util/sensor_health.h"
+#include "../include/util/sensor_log.h"
+#include "../include/util/sim_clock.h"
 #include "../include/camera/logical_camera.h"
+#include "../include/camera/part_index.h"
+#include "../include/camera/inventory.h"
 #include "../include/arm/arm.h"
+#include "../include/comp/order_scheduler.h"
 
 
 void as_submit_assembly(ros::NodeHandle & node, std::string station_id, std::string shipment_type)
@@ -82,6 +94,326 @@ void as_submit_assembly(ros::NodeHandle & node, std::string station_id, std::str
 }
 
 
+namespace {
+  // Longest time an AGV takes from its kitting station to an assembly station
+  const ros::Duration kAgvTravelTimeout(60.0);
+  // Sim time by which the conveyor belt carries parts, if it carries any
+  const ros::Time kConveyorDeadline(25.0);
+  // Time waited for an order before checking the competition state again
+  const ros::Duration kOrderPoll(1.0);
+  // Time given to a later order once every order received is done
+  const ros::Duration kLastOrderWait(30.0);
+}
+
+/**
+ * @brief Robots, sensors and parts the shipments are run with
+ * 
+ */
+struct Workcell
+{
+  ros::NodeHandle & node;
+  motioncontrol::Arm & arm;
+  gantry_motioncontrol::Gantry & gantry;
+  LogicalCamera & cam;
+  // Parts in the bins, marked as they are used
+  std::map<std::string, std::vector<Product> > & cam_map;
+  // Parts of cam_map seen by the bin cameras, by position
+  motioncontrol::PartIndex bin_index;
+  std::vector<int> & empty_bins;
+  // Trays of the kits shipped to each assembly station
+  std::map<std::string, std::vector<motioncontrol::TrayId> > kits_shipped;
+  // Parts seen when the first shipment of each assembly station started, marked as they are used
+  std::map<std::string, std::map<std::string, std::vector<Product> > > station_parts;
+};
+
+/**
+ * @brief Free part of a type in the bins closest to its placement target
+ * 
+ * @param cell Workcell
+ * @param target Product of the shipment, with its target pose resolved
+ * @return Product* nullptr if none is left
+ */
+Product* free_bin_part(Workcell & cell, const Product & target)
+{
+  return cell.bin_index.nearestFree(target.type, target.target_pose.position);
+}
+
+/**
+ * @brief Move a part from a bin to a kit tray
+ * 
+ * The kitting arm serves the bins next to the conveyor, the gantry the
+ * others. A pump that goes upside down in the tray but lies the right
+ * way up in its bin is flipped on the way.
+ * 
+ * @param cell Workcell
+ * @param part Part in a bin
+ * @param target Product of the shipment
+ * @param agv AGV of the kit tray
+ */
+void place_in_tray(Workcell & cell, const Product & part, const Product & target, const std::string & agv)
+{
+  bool flip = false;
+  if (target.type.name().find("pump") != std::string::npos){
+    const bool upside_down = std::abs(std::abs(motioncontrol::eulerFromQuaternion(target.frame_pose)[0]) - 3.14) < 0.5;
+    const bool lies_upside_down = std::abs(std::abs(motioncontrol::eulerFromQuaternion(part.world_pose)[0]) - 3.14) < 0.5;
+    flip = upside_down && !lies_upside_down;
+  }
+  // A flip needs a free spot in a staging bin, without one the part is placed as it lies
+  int flip_bin = 0;
+  if (flip && !cell.arm.reserveFlipSpot(target.type, cell.empty_bins, flip_bin)){
+    ROS_WARN_STREAM("Placing " << target.type << " without flipping it");
+    flip = false;
+  }
+
+  // Check if the part in is the bins near to the conveyor
+  if (part.bin_number == 1 || part.bin_number == 2 || part.bin_number == 5 || part.bin_number == 6){
+    ROS_INFO_STREAM("Moving the part using kitting arm: " << target.type);
+    if (flip){
+      cell.arm.flippart(part, flip_bin, target.frame_pose, agv, true);
+    }
+    else{
+      cell.arm.movePart(target.type, part.world_pose, target.frame_pose, agv);
+    }
+    return;
+  }
+
+  ROS_INFO_STREAM("Moving the part using gantry: " << target.type);
+  if (part.camera == motioncontrol::SensorId::kBins0){
+    cell.gantry.goToPresetLocation(cell.gantry.at_bins1234_);
+  }
+  else{
+    cell.gantry.goToPresetLocation(cell.gantry.at_bins5678_);
+  }
+  cell.gantry.move_gantry_to_bin(part.bin_number);
+  if (flip){
+    // The gantry drops the part in the bin the kitting arm flips it in
+    cell.gantry.movePartfrombin(part.world_pose, target.type, flip_bin);
+    cell.arm.flippart(part, flip_bin, target.frame_pose, agv, false);
+  }
+  else{
+    cell.gantry.movePart(part.world_pose, target.frame_pose, agv, target.type);
+    cell.gantry.goToPresetLocation(cell.gantry.home_);
+  }
+}
+
+/**
+ * @brief Take a faulty part off a kit tray
+ * 
+ * @param cell Workcell
+ * @param faulty_part Part reported by the quality control sensor
+ */
+void remove_faulty_part(Workcell & cell, const Product & faulty_part)
+{
+  cell.arm.pickfaulty(faulty_part.type, faulty_part.world_pose);
+  cell.arm.goToPresetLocation(motioncontrol::ArmPreset::kHome2);
+  cell.arm.deactivateGripper();
+}
+
+/**
+ * @brief Check the parts placed during a sensor blackout
+ * 
+ * A faulty part is taken off the tray and its product is placed again.
+ * 
+ * @param cell Workcell
+ * @param kit Shipment
+ */
+void check_blackout_parts(Workcell & cell, motioncontrol::ShipmentTask & kit)
+{
+  for (auto i: kit.unchecked){
+    auto &later = kit.products.at(i);
+    Product faulty_part;
+    if (cell.cam.wait_for_faulty_part(kit.destination, later.target_pose, motioncontrol::kFaultTimeout, faulty_part)){
+      ROS_INFO_STREAM("Checked: part is faulty, removing it from the tray");
+      remove_faulty_part(cell, faulty_part);
+      // place the part again
+      later.processed = false;
+    }
+  }
+  kit.unchecked.clear();
+}
+
+/**
+ * @brief Fill the kit tray of a kitting shipment and ship its AGV
+ * 
+ * Checks for a more urgent shipment before every pick.
+ * 
+ * @param cell Workcell
+ * @param kit Shipment
+ * @return true AGV shipped
+ * @return false Preempted, the products not placed yet are left for the next run
+ */
+bool run_kitting(Workcell & cell, motioncontrol::ShipmentTask & kit)
+{
+  ROS_INFO_STREAM("[CURRENT PROCESS]: " << kit.shipment_type);
+  if (kit.runs == 1){
+    // Leave out the parts the workcell cannot supply and ship the rest
+    auto shipment_check = motioncontrol::Inventory::instance().check(kit.products);
+    for (const auto &missing: shipment_check.missing){
+      ROS_WARN_STREAM("Shipping " << kit.shipment_type << " without " << missing.second << " " << missing.first);
+      for (std::size_t n{0}; n < missing.second; n++){
+        auto last = std::find_if(kit.products.rbegin(), kit.products.rend(),
+          [&missing](const Product &part){ return part.type == missing.first; });
+        kit.products.erase(std::next(last).base());
+      }
+    }
+  }
+  // Resolve all the targets in the tray before the robot starts moving
+  motioncontrol::TrayTransforms::instance().placementTargets(kit.products, kit.destination,
+    ros::Time::now() + motioncontrol::kTransformTimeout);
+
+  while (true){
+    auto iter = std::find_if(kit.products.begin(), kit.products.end(),
+      [](const Product &part){ return !part.processed; });
+    if (iter == kit.products.end()){
+      if (kit.unchecked.empty()){
+        break;
+      }
+      // Check the parts placed during a sensor blackout once the sensors are back
+      if (motioncontrol::SensorHealth::instance().waitForSensors(ros::Time::now() + motioncontrol::kBlackoutWait)){
+        check_blackout_parts(cell, kit);
+      }
+      else{
+        ROS_WARN_STREAM("Sensors still down, parts placed during the blackout are not checked");
+        kit.unchecked.clear();
+      }
+      continue;
+    }
+
+    // A blackout that ended while parts were placed: check them before the next pick
+    for (const auto &event: motioncontrol::SensorHealth::instance().takeEvents()){
+      if (event.type == motioncontrol::HealthEvent::Type::kBlackoutEnded && !kit.unchecked.empty() &&
+        !motioncontrol::SensorHealth::instance().blackout()){
+        ROS_INFO_STREAM("Sensor blackout ended, checking " << kit.unchecked.size() << " part(s) placed during it");
+        check_blackout_parts(cell, kit);
+      }
+    }
+
+    // Safe point: the previous part is placed, the next one is not picked yet
+    if (motioncontrol::OrderScheduler::instance().preempt(kit)){
+      return false;
+    }
+
+    ROS_INFO_STREAM("[CURRENT PART BEING PROCESSED]: " << iter->type);
+    Product* part = free_bin_part(cell, *iter);
+    if (!part){
+      ROS_WARN_STREAM("Shipping " << kit.shipment_type << " without a " << iter->type << ", none left in the bins");
+      iter->processed = true;
+      continue;
+    }
+    // Out of the free parts while the robot carries it, so checks of new orders do not count it
+    motioncontrol::Inventory::instance().reserve(*part);
+    place_in_tray(cell, *part, *iter, kit.destination);
+    part->status = motioncontrol::PartStatus::kProcessed;
+    motioncontrol::Inventory::instance().consume(*part);
+
+    if (motioncontrol::SensorHealth::instance().blackout()){
+      // No verdict during a blackout: count the part now and check it when the sensors are back
+      ROS_INFO_STREAM("Sensor Blackout, checking " << iter->type << " later");
+      kit.unchecked.push_back(static_cast<std::size_t>(iter - kit.products.begin()));
+      iter->processed = true;
+      continue;
+    }
+    // Wait for the verdict of the quality control sensor on the placed part
+    Product faulty_part;
+    if (cell.cam.wait_for_faulty_part(kit.destination, iter->target_pose, motioncontrol::kFaultTimeout, faulty_part)){
+      ROS_INFO_STREAM("part is faulty, removing it from the tray");
+      remove_faulty_part(cell, faulty_part);
+      continue;
+    }
+    iter->processed = true;
+  }
+
+  motioncontrol::SimClock::instance().sleepFor(ros::Duration(2.0));
+  motioncontrol::Agv agv{cell.node, kit.destination};
+  agv.shipAgv(kit.shipment_type, kit.station_id);
+  motioncontrol::TrayId tray;
+  if (motioncontrol::trayFromLocation(kit.destination, tray))
+    cell.kits_shipped[kit.station_id].push_back(tray);
+  ROS_INFO_STREAM("AGV Shipped "<< kit.destination);
+  return true;
+}
+
+/**
+ * @brief Assemble the parts of an assembly shipment and submit it
+ * 
+ * Checks for a more urgent shipment before every pick.
+ * 
+ * @param cell Workcell
+ * @param asmb Shipment
+ * @return true Submitted
+ * @return false Preempted, the products not placed yet are left for the next run
+ */
+bool run_assembly(Workcell & cell, motioncontrol::ShipmentTask & asmb)
+{
+  ROS_INFO_STREAM("[CURRRENT PROCESS]: " << asmb.shipment_type);
+  auto station_parts = cell.station_parts.find(asmb.destination);
+  if (station_parts == cell.station_parts.end()){
+    // Wait for the kits shipped to the station
+    auto shipped = cell.kits_shipped.find(asmb.destination);
+    if (shipped != cell.kits_shipped.end()){
+      ROS_INFO_STREAM("Waiting for agv to reach the assembly station");
+      const ros::Time deadline = ros::Time::now() + kAgvTravelTimeout;
+      for (auto tray : shipped->second){
+        if (!motioncontrol::TrayTransforms::instance().waitForStation(tray, asmb.destination, deadline))
+          ROS_WARN_STREAM("[My_node] " << motioncontrol::trayInfo(tray).location << " not at " << asmb.destination);
+      }
+    }
+    // find parts seen by logical cameras
+    auto list = cell.cam.scan(LogicalCamera::scanned_cameras(), ros::Time::now() + motioncontrol::kScanTimeout).get().parts;
+    cell.cam.segregate_parts(list);
+    station_parts = cell.station_parts.emplace(asmb.destination, cell.cam.get_camera_map()).first;
+  }
+  auto &parts = station_parts->second;
+
+  // Resolve all the targets in the tray before the robot starts moving
+  motioncontrol::TrayTransforms::instance().placementTargets(asmb.products, asmb.destination,
+    ros::Time::now() + motioncontrol::kTransformTimeout);
+
+  for (auto &iter: asmb.products){
+    if (iter.processed){
+      continue;
+    }
+    // Safe point: the previous part is placed, the next one is not picked yet
+    if (motioncontrol::OrderScheduler::instance().preempt(asmb)){
+      return false;
+    }
+
+    Product* part = nullptr;
+    auto p = parts.find(iter.type);
+    if (p != parts.end()){
+      for (auto &candidate: p->second){
+        if (candidate.status == motioncontrol::PartStatus::kFree &&
+          std::string(motioncontrol::sensorInfo(candidate.camera).name).find(asmb.destination) != std::string::npos){
+          part = &candidate;
+          break;
+        }
+      }
+    }
+    if (!part){
+      ROS_WARN_STREAM("Submitting " << asmb.shipment_type << " without a " << iter.type << ", none at " << asmb.destination);
+      iter.processed = true;
+      continue;
+    }
+    ROS_INFO_STREAM("Moving the part: " << iter.type);
+    cell.gantry.move_gantry_to_assembly_station(motioncontrol::sensorInfo(part->camera).name);
+    motioncontrol::Inventory::instance().reserve(*part);
+    cell.gantry.movePart(part->world_pose, iter.frame_pose, asmb.destination, iter.type);
+    part->status = motioncontrol::PartStatus::kProcessed;
+    motioncontrol::Inventory::instance().consume(*part);
+    iter.processed = true;
+  }
+
+  motioncontrol::SimClock::instance().sleepFor(ros::Duration(1.0));
+  as_submit_assembly(cell.node, asmb.destination, asmb.shipment_type);
+  if(( asmb.destination.compare("as2") == 0) || ( asmb.destination.compare("as4") == 0))
+  {
+    cell.gantry.goToPresetLocation(cell.gantry.home2_);
+  }
+  cell.gantry.goToPresetLocation(cell.gantry.home_);
+  return true;
+}
+
+
 int main(int argc, char ** argv)
 {
   // Last argument is the default name of the node.
@@ -92,11 +424,30 @@ int main(int argc, char ** argv)
   spinner.start();
 
   ros::Time start = ros::Time::now();
+
+  // Fill the shared TF buffer before anything needs a transform
+  motioncontrol::TransformService::instance().warmup(
+    {"logical_camera_bins0_frame", "logical_camera_bins1_frame",
+     "kit_tray_1", "kit_tray_2", "kit_tray_3", "kit_tray_4"}, ros::Duration(5.0));
+
+  // Sensor poses from the user config, loaded by ariac.launch
+  motioncontrol::WorkcellTransforms::instance().load(node, "/group5_workcell/sensors");
+
+  // Number of static frames added for tray poses, bounded by the pool size
+  motioncontrol::ScratchFrames::instance().advertise(node, "/group5/scratch_frames/live");
+
+  // Sensor traffic for offline replay, when ~record names a file
+  std::string record_path;
+  if (ros::NodeHandle("~").getParam("record", record_path))
+    motioncontrol::SensorRecorder::instance().start(node, record_path);
+
   // Instance of custom class from above.
   MyCompetitionClass comp_class(node);
   comp_class.init();
 
+  motioncontrol::SensorHealth::instance().start(node);
   LogicalCamera cam(node);
+  cam.init();
 
   // create an instance of the kitting arm
   motioncontrol::Arm arm(node);
@@ -104,18 +455,14 @@ int main(int argc, char ** argv)
   gantry_motioncontrol::Gantry gantry(node);
   gantry.init();
 
-  // ros::Subscriber depth_camera_bins1_subscriber = node.subscribe(
-  //   "/ariac/depth_camera_bins1/depth/image_raw --noarr", 10,
-  //   &MyCompetitionClass::depth_camera_bins1_callback, &comp_class);
+  ros::Subscriber depth_camera_bins1_subscriber = node.subscribe(
+    "/ariac/depth_camera_bins1/depth/points", 1,
+    &MyCompetitionClass::depth_camera_bins1_callback, &comp_class);
 
   ros::Subscriber proximity_sensor_subscriber = node.subscribe(
     "/ariac/proximity_sensor_0", 10,
      &MyCompetitionClass::proximity_sensor0_callback,&comp_class);
 
-  ros::Subscriber break_beam_subscriber = node.subscribe(
-    "/ariac/breakbeam_0", 10,
-    &MyCompetitionClass::breakbeam0_callback, &comp_class);
-
   ros::Subscriber laser_profiler_subscriber = node.subscribe(
     "/ariac/laser_profiler_0", 10,
     &MyCompetitionClass::laser_profiler0_callback,&comp_class);
@@ -131,54 +478,21 @@ int main(int argc, char ** argv)
   nist_gear::AssemblyStationSubmitShipment asrv;
 
 
-  std::vector<Order> orders;
-  std::string comp_state;
-  Product remaining_part;
-  std::string remaining_part_agv;
-  std::string remaining_part_as;
-  std::string remaining_shipment_type;
-  std::vector<std::string> parts_not_found;
-  std::string blackout_part_type;
-  geometry_msgs::Pose blackout_part_tray_pose;
-  std::string check_agv_id;
- 
-  std::vector<Product> parts_to_check_later;
-  // comp_state = comp_class.getCompetitionState();
-  auto competition_start_time = comp_class.getClock();
-
-  
-  // Boolean Flags
-  bool order0_done = false;
-  bool order1_models_found = false;
-  bool remaining_found = false;
-  bool remaining_shipment = false;
-  bool finished = false;
-  bool noblackout = true;
-  bool check_later = false;
-  bool notfinished = true;
-  bool order1_done = false;
-  bool check_order0_kits = true;
-  unsigned short int id{}; 
   ros::Rate rate = 2;	  
   rate.sleep();	
 
 
 
-  // find parts seen by logical cameras
-  auto list1 = cam.findparts();  
-  ros::Duration(sleep(5.0)); 
+  // wait for the first image of every scanned camera
+  cam.scan(LogicalCamera::scanned_cameras(), ros::Time::now() + ros::Duration(5.0)).wait();
 
   // Finding empty bins 
   auto empty_bins_at_start = cam.get_ebin_list();
   auto empty_bins = empty_bins_at_start;
-  ros::Duration(sleep(1.0));
   for(auto &bin: empty_bins_at_start){
     ROS_INFO_STREAM("Empty bin numbers: "<< bin);
   }
-  double Check_time = ros::Time::now().toSec();
-  while(!(comp_class.conveyor_check()) && Check_time <=25){
-    Check_time = ros::Time::now().toSec();
-  }
+  comp_class.wait_for_conveyor(kConveyorDeadline);
   
   // std::vector<int> empty_bins;
   // Pick parts from conveyor
@@ -195,11 +509,10 @@ int main(int argc, char ** argv)
   
   ROS_INFO_STREAM("Making List");
 
-  auto list = cam.findparts(); 
+  auto list = cam.scan(LogicalCamera::scanned_cameras(), ros::Time::now() + motioncontrol::kScanTimeout).get().parts; 
 
   ROS_INFO_STREAM("Made List");
 
-  ros::Duration(sleep(3.0));
   // empty_bins = cam.get_ebin_list();
   for(auto &bin: empty_bins){
     ROS_INFO_STREAM("Empty bin after conveyor check: "<< bin);
@@ -211,7 +524,6 @@ int main(int argc, char ** argv)
 
   ROS_INFO_STREAM("Segd list");
 
-  ros::Duration(sleep(3.0));
 
   // get the map of parts
   ROS_INFO_STREAM("Creating map");
@@ -221,797 +533,43 @@ int main(int argc, char ** argv)
   ROS_INFO_STREAM("Created map");
 
 
-  ros::Duration(sleep(3.0));
-  arm.goToPresetLocation("home1");
-  arm.goToPresetLocation("home2");
+  arm.goToPresetLocation(motioncontrol::ArmPreset::kHome1);
+  arm.goToPresetLocation(motioncontrol::ArmPreset::kHome2);
   gantry.goToPresetLocation(gantry.home_);
 
-  // find parts seen by logical cameras
-   
-  ros::Duration(sleep(3.0));
-  while(ros::ok){
-  
-  // get the list of orders
-  orders = comp_class.get_order_list();  
-  // Process order 0
-  if (notfinished)
-  {
-    if (!order0_done){
-      // kitting
-      for(auto &kit: orders.at(0).kitting){
-
-        ROS_INFO_STREAM("[CURRENT PROCESS]: " << kit.shipment_type);
-         // Create an empty list of parts for the kit
-        std::vector<Product> parts_for_kitting;
-        // Push all the parts in kit to the list
-        for (auto &part:kit.products){
-          part.processed = false;
-          parts_for_kitting.push_back(part);
-        }
-        
-        unsigned short int shipment_product_count{0};
-
-        while(shipment_product_count <= kit.products.size()){
-          if (shipment_product_count == kit.products.size()){
-            ROS_INFO_STREAM(shipment_product_count);
-            ROS_INFO_STREAM("SHIP");
-            break;
-          }
-          ROS_INFO_STREAM("SHIPMENT COUNT: " << shipment_product_count);
-          // Process the shipment
-          int counter{0};
-          for(auto &iter: parts_for_kitting){
-
-            ROS_INFO_STREAM("Number of parts for kitting " << parts_for_kitting.size());
-            ROS_INFO_STREAM(counter);
-            counter++;
-
-            if (shipment_product_count == kit.products.size()){
-            ROS_INFO_STREAM(shipment_product_count);
-            ROS_INFO_STREAM("SHIP inside for");
-            break;
-            }
-
-            ROS_INFO_STREAM("[CURRENT PART BEING PROCESSED]: " << iter.type);
-
-            if (!iter.processed){
-              // Find the required part from the map of parts
-              auto p = cam_map.find(iter.type);
-              
-              // Search the part from the map
-              for (int i{0}; i < p->second.size(); i++){
-                
-                // Check if the part is not already picked before, i.e., is present on bin
-                if(p->second.at(i).status.compare("free") == 0){
-                  
-                  // Check if part is in the eight bins. 
-                  if ((p->second.at(i).camera.compare("logical_camera_bins0") == 0) || (p->second.at(i).camera.compare("logical_camera_bins1") == 0) ){
-                    
-                    // Check if the part in is the bins near to the conveyor
-                    if (p->second.at(i).bin_number == 1 || p->second.at(i).bin_number == 2 || p->second.at(i).bin_number == 5 || p->second.at(i).bin_number == 6){
-                      
-                      ROS_INFO_STREAM("Moving the part using kitting arm: " << iter.type);
-                      
-                      // Check if the part is a pump
-                      if(iter.type.find("pump") != std::string::npos){
-                        std::array<double, 3> rpy = motioncontrol::eulerFromQuaternion(iter.frame_pose);
-                        auto roll = rpy[0];
-                        // ROS_INFO_STREAM("Roll :" <<roll);
-
-                        // Check is the pump is to be flipped
-                        if(abs(abs(roll) - 3.14) < 0.5){ 
-                          auto part = p->second.at(i);        
-                          std::array<double, 3> rpy_part = motioncontrol::eulerFromQuaternion(part.world_pose);
-                          if(abs(abs(rpy_part[0]) - 3.14) < 0.5){
-                            arm.movePart(iter.type, p->second.at(i).world_pose, iter.frame_pose, kit.agv_id);
-                            cam_map[iter.type].at(i).status = "processed";
-                          }
-                          else{
-                            arm.flippart(part, empty_bins, iter.frame_pose, kit.agv_id, true);
-                            cam_map[iter.type].at(i).status = "processed";
-                          }
-                        }
-                        else{
-                          arm.movePart(iter.type, p->second.at(i).world_pose, iter.frame_pose, kit.agv_id);
-                          cam_map[iter.type].at(i).status = "processed";
-
-                        }
-                      }
-
-                      // Part is not a pump
-                      else{
-                        arm.movePart(iter.type, p->second.at(i).world_pose, iter.frame_pose, kit.agv_id);
-                        cam_map[iter.type].at(i).status = "processed";
-                      }
-                    }
-
-                    // Part is in bins away from conveyor
-                    else{
-                      ROS_INFO_STREAM("Moving the part using gantry: " << iter.type);
-                      
-                      // Check is the part is in bins0
-                      if(p->second.at(i).camera.compare("logical_camera_bins0") == 0){
-                        gantry.goToPresetLocation(gantry.at_bins1234_);
-                      }
-                      // else, the parts are in bins1
-                      else{
-                        gantry.goToPresetLocation(gantry.at_bins5678_);
-                      }
-
-                      if(iter.type.find("pump") != std::string::npos) {
-                        std::array<double, 3> rpy = motioncontrol::eulerFromQuaternion(iter.frame_pose);
-                        auto roll = rpy[0];
-                        // ROS_INFO_STREAM("Roll :" << roll);
-                        
-                        if (abs(abs(roll) - 3.14) < 0.5){
-                          auto part = p->second.at(i);
-                          std::array<double, 3> rpy_part = motioncontrol::eulerFromQuaternion(part.world_pose);
-                          if(abs(abs(rpy_part[0]) - 3.14) < 0.5){
-                            gantry.move_gantry_to_bin(p->second.at(i).bin_number);
-                            gantry.movePart(p->second.at(i).world_pose, iter.frame_pose, kit.agv_id, iter.type);
-                            gantry.goToPresetLocation(gantry.home_);
-                            cam_map[iter.type].at(i).status = "processed";
-                          }
-                          else{
-                            int bin_selected = 0;
-                            for(auto &bin: empty_bins){
-                                // ROS_INFO_STREAM("bin number "<< bin);
-                                if(bin == 1 || bin == 2 || bin == 5 || bin == 6)
-                                {
-                                    bin_selected = bin;
-                                    break;
-                                }
-                            }
-                            if(bin_selected == 0){
-                              bin_selected = 2;
-                            }
-                            gantry.move_gantry_to_bin(p->second.at(i).bin_number);
-                            gantry.movePartfrombin(p->second.at(i).world_pose, iter.type, bin_selected);
-                            arm.flippart(part, empty_bins, iter.frame_pose, kit.agv_id, false);
-                            cam_map[iter.type].at(i).status = "processed";
-                          }
-                        }
-                        
-                        else{
-                        gantry.move_gantry_to_bin(p->second.at(i).bin_number);
-                        gantry.movePart(p->second.at(i).world_pose, iter.frame_pose, kit.agv_id, iter.type);
-                        gantry.goToPresetLocation(gantry.home_);
-                        cam_map[iter.type].at(i).status = "processed";
-                        }
-
-                      }
-
-                      else{
-                        gantry.move_gantry_to_bin(p->second.at(i).bin_number);
-                        gantry.movePart(p->second.at(i).world_pose, iter.frame_pose, kit.agv_id, iter.type);
-                        gantry.goToPresetLocation(gantry.home_);
-                        cam_map[iter.type].at(i).status = "processed";
-                      }
-                    }
-                  }
-                    
-
-                  // Check for Sensor Blackout
-                  if(ros::Time::now().toSec() - comp_class.CheckBlackout() > 2){
-                    ROS_INFO_STREAM("Sensor Blackout");
-                    noblackout = false;
-                  }
-                  else{
-                    noblackout = true;
-                  }
-                  
-                  if (noblackout){
-                    // HIGH PRIORITY ORDER PROCESSING
-                    // Check if high priority order is announced
-                    ROS_INFO_STREAM("High Priority value: " << comp_class.high_priority_announced);
-                    if(comp_class.high_priority_announced && !order1_done){
-                      while(true){
-                        auto temp_order_list = comp_class.get_order_list();
-                        if(temp_order_list.size() > 1){
-                          if (temp_order_list.at(1).kitting.size() > 0){
-                          for(auto &kit1: temp_order_list.at(1).kitting){
-
-                            ROS_INFO_STREAM("[CURRENT PROCESS order 1]: " << kit1.shipment_type);
-
-                            // Create an empty list of parts for this kit
-                            std::vector<Product> parts_for_kitting1;
-
-                            // Push all the parts in kit to the list
-                            for (auto &part:kit1.products){
-                              part.processed = false;
-                              parts_for_kitting1.push_back(part);
-                            }
-
-                            unsigned short int product_placed_in_shipment{0};
-
-                            // Process the shipment
-                            for(auto &iter: parts_for_kitting1){
-
-                              if (!iter.processed){
-                                // Find the required part from the map of parts
-                                auto p = cam_map.find(iter.type);
-                                // Search the part from the map
-                                for (int i{0}; i < p->second.size(); i++){
-                                  // Check if the part is not already picked before, i.e., is present on bin
-                                  if(p->second.at(i).status.compare("free") == 0){
-                                    // Pick and place the part from bin to agv tray
-                                    arm.movePart(iter.type, p->second.at(i).world_pose, iter.frame_pose, kit1.agv_id);
-                                    // Update the status of the picked up part
-                                    cam_map[iter.type].at(i).status = "processed";
-                                    
-                                    if (noblackout){
-                                      // Get the data from quality control sensors	
-                                      cam.query_faulty_cam();
-                                      auto faulty_list = cam.get_faulty_part_list();
-                                      
-                                      double outside_time = ros::Time::now().toSec();
-                                      double inside_time = ros::Time::now().toSec();
-                                      // Delay for list construction
-                                      ROS_INFO_STREAM("entering delay");
-                                      
-                                      while (inside_time - outside_time < 4.0) {
-                                          inside_time = ros::Time::now().toSec();
-                                      }
-                                      
-                                      // Check if part is faulty
-                                      if (cam.faulty_part_list_.size() > 1){
-                                        unsigned short int id{0};
-                                        // if (cam.faulty_part_list_.at(0).faulty_cam_agv.compare(kit.agv_id) == 0){
-                                        //   id = 0;
-                                        // }
-                                        // if (cam.faulty_part_list_.at(1).faulty_cam_agv.compare(kit.agv_id) == 0){
-                                        //   id = 1;
-                                        // }
-                                        if (abs(cam.faulty_part_list_.at(0).world_pose.position.y - iter.world_pose.position.y) < 0.2 && abs(cam.faulty_part_list_.at(0).world_pose.position.x - iter.world_pose.position.x) < 0.2){
-                                          id = 0;
-                                        }
-                                        if (abs(cam.faulty_part_list_.at(1).world_pose.position.y - iter.world_pose.position.y) < 0.2 && abs(cam.faulty_part_list_.at(1).world_pose.position.x - iter.world_pose.position.x) < 0.2){
-                                          id = 1;
-                                        }
-                                        ROS_INFO_STREAM("part is faulty, removing it from the tray size 1");
-                                        arm.pickfaulty(iter.type, cam.faulty_part_list_.at(id).world_pose);
-                                        arm.goToPresetLocation("home2");
-                                        arm.deactivateGripper();
-                                        cam.query_faulty_cam();
-                                        continue;
-                                      }
-                                      if (cam.faulty_part_list_.size() == 1){
-                                        ROS_INFO_STREAM("part is faulty, removing it from the tray");
-                                        arm.pickfaulty(iter.type, cam.faulty_part_list_.at(0).world_pose);
-                                        arm.goToPresetLocation("home2");
-                                        arm.deactivateGripper();
-                                        cam.query_faulty_cam();
-                                        continue;
-                                      }
-                                      iter.processed = true;
-                                      break;
-                                    }
-                                    else{
-                                      break;
-                                    }
-                                  } 
-                                }
-                              }
-                              product_placed_in_shipment++;
-                            }
-                            if(product_placed_in_shipment == kit1.products.size()){
-                              ros::Duration(sleep(1.0));
-                              motioncontrol::Agv agv{node, kit1.agv_id};
-                              if (agv.getAGVStatus()){
-                                agv.shipAgv(kit1.shipment_type, kit1.station_id);
-                              }
-                            }
-                          }}
-                          // Order 1 kitting done
-
-                          /// Order 1 Assembly
-                          if (temp_order_list.at(1).assembly.size() > 0){
-                            ROS_INFO_STREAM("inside order 1 Assembly");
-                            double outside_time = ros::Time::now().toSec();
-                            double inside_time = ros::Time::now().toSec();
-                            while (inside_time - outside_time < 15.0) {
-                                inside_time = ros::Time::now().toSec();
-                            }
-                            
-                            // find parts seen by logical cameras
-                            ROS_INFO_STREAM("Finding parts");
-                            auto list_o1p = cam.findparts();
-                            ros::Duration(sleep(3.0));
-
-                            ROS_INFO_STREAM("Seg list");
-                             
-                            // Segregate parts and create the map of parts
-                            cam.segregate_parts(list_o1p);
-                            ros::Duration(sleep(3.0));
-                            
-                            ROS_INFO_STREAM("map creation");
-                            // get the map of parts
-                            auto cam_map_o1p = cam.get_camera_map();
-                            outside_time = ros::Time::now().toSec();
-                            inside_time = ros::Time::now().toSec();
-                            // Delay for list construction
-                            ROS_INFO_STREAM("entering delay");
-                            while (inside_time - outside_time < 5.0) {
-                              inside_time = ros::Time::now().toSec();
-                            }
-                            
-
-                            for(auto &asmb: temp_order_list.at(1).assembly){
-                              ROS_INFO_STREAM("[CURRRENT PROCESS]: " << asmb.shipment_type);
-
-                              std::vector<Product> parts_for_assembly;
-                              for (auto &part:asmb.products){
-                                part.processed = false;
-                                parts_for_assembly.push_back(part);
-                              }
-                              unsigned short int shipment_product_count(0);
-                              std::string assembly_station = asmb.stations;
-                              while(shipment_product_count <= asmb.products.size()){
-                                if (shipment_product_count == asmb.products.size()){
-                                  break;
-                                }
-                                for(auto &iter: parts_for_assembly){
-                                  // ROS_INFO_STREAM(iter.type);
-                                  auto p = cam_map_o1p.find(iter.type);
-                                  if (p != cam_map_o1p.end()){
-                                    for (int i{0}; i < p->second.size(); i++){
-                                      if (p->second.at(i).camera.find(assembly_station) != std::string::npos){
-                                        ROS_INFO_STREAM("Moving the part: " << iter.type);
-                                        gantry.move_gantry_to_assembly_station(p->second.at(i).camera);
-                                        gantry.movePart(p->second.at(i).world_pose, iter.frame_pose, asmb.stations, iter.type);
-                                        shipment_product_count++;
-                                        break;
-                                      }
-                                    }
-                                  }
-                                }
-                              }
-                              ros::Duration(sleep(1.0));
-                              as_submit_assembly(node, asmb.stations, asmb.shipment_type);
-                              if(( asmb.stations.compare("as2") == 0) || ( asmb.stations.compare("as4") == 0))
-                              {
-                                gantry.goToPresetLocation(gantry.home2_);
-                              }
-                              gantry.goToPresetLocation(gantry.home_);
-                              parts_for_assembly.clear();
-
-                            }
-                          }
-                          order1_done = true;
-                          break; 
-                        }
-                      }
-                    }                    
-
-                    // Get the data from quality control sensors	
-                    cam.query_faulty_cam();
-                    auto faulty_list = cam.get_faulty_part_list();
-                    
-                    double outside_time = ros::Time::now().toSec();
-                    double inside_time = ros::Time::now().toSec();
-                    // Delay for list construction
-                    ROS_INFO_STREAM("entering delay");
-                    while (inside_time - outside_time < 4.0) {
-                        inside_time = ros::Time::now().toSec();
-                    }
-                    ROS_INFO_STREAM("Number of faulty parts in list: " << cam.faulty_part_list_.size());
-                    
-                    // Check if part is faulty
-                    if (cam.faulty_part_list_.size() > 1){
-                      unsigned short int id{0};
-                      if (abs(cam.faulty_part_list_.at(0).world_pose.position.y - iter.world_pose.position.y) < 0.2 && abs(cam.faulty_part_list_.at(0).world_pose.position.x - iter.world_pose.position.x) < 0.2){
-                        id = 0;
-                      }
-                      if (abs(cam.faulty_part_list_.at(1).world_pose.position.y - iter.world_pose.position.y) < 0.2 && abs(cam.faulty_part_list_.at(1).world_pose.position.x - iter.world_pose.position.x) < 0.2){
-                        id = 1;
-                      }
-                      ROS_INFO_STREAM("part is faulty, removing it from the tray size 1");
-                      
-                      arm.pickfaulty(iter.type, cam.faulty_part_list_.at(id).world_pose);
-                      arm.goToPresetLocation("home2");
-                      arm.deactivateGripper();
-                      cam.query_faulty_cam();
-                      continue;
-                    }
-                    if (cam.faulty_part_list_.size() == 1){
-                      if (abs(cam.faulty_part_list_.at(0).world_pose.position.y - iter.world_pose.position.y) < 0.2 && abs(cam.faulty_part_list_.at(0).world_pose.position.x - iter.world_pose.position.x) < 0.2){ 
-                        ROS_INFO_STREAM("part is faulty, removing it from the tray");
-                        arm.pickfaulty(iter.type, cam.faulty_part_list_.at(0).world_pose);
-                        arm.goToPresetLocation("home2");
-                        arm.deactivateGripper();
-                        cam.query_faulty_cam();
-                        continue;
-                     }
-                    }
-                    
-                    iter.processed = true;
-                    ROS_INFO_STREAM("Labelled as processed" << iter.type);
-                    shipment_product_count++;
-                    ROS_INFO_STREAM("Shipment count after processed: " << shipment_product_count);
-                    break;
-                  }
-                  else{
-                    parts_to_check_later.push_back(iter);
-                    ROS_INFO_STREAM("Pushed in to check later: " << iter.type);
-                    break;
-                  }
-                } 
-              }
-            }
-
-          }
-          // Check for faulty part, part was placed during sensor blackout
-          if (cam.faulty_part_list_.size() > 0 ){
-            ROS_INFO_STREAM("Checked: part is faulty, removing it from the tray");
-            arm.pickfaulty(parts_to_check_later.at(0).type, cam.faulty_part_list_.at(0).world_pose);
-            arm.goToPresetLocation("home2");
-            arm.deactivateGripper();
-            cam.query_faulty_cam();
-            // break;
-          }
-          else{
-            shipment_product_count++;
-          }
-        }
-        
-        ros::Duration(sleep(2.0));
-        ROS_INFO_STREAM(kit.agv_id);
-        ROS_INFO_STREAM(kit.station_id);
-        motioncontrol::Agv agv{node, kit.agv_id};
-        ros::Duration(sleep(2.0));
-        agv.shipAgv(kit.shipment_type, kit.station_id);
-        ROS_INFO_STREAM("AGV Shipped "<< kit.agv_id);
-        ROS_INFO_STREAM("Moving to next shipment");
-      }
-
-      /// Order 0 Assembly
-      if (orders.at(0).assembly.size() > 0){
-         
-      
-        ROS_INFO_STREAM("inside order 0 Assembly");
-        double outside_time = ros::Time::now().toSec();
-        double inside_time = ros::Time::now().toSec();
-        while (inside_time - outside_time < 15.0) {
-            inside_time = ros::Time::now().toSec();
-        }
-        // find parts seen by logical cameras
-        ROS_INFO_STREAM("Finding parts");
-        auto list_o0 = cam.findparts();
-        ROS_INFO_STREAM("Seg list"); 
-        // Segregate parts and create the map of parts
-        cam.segregate_parts(list_o0);
-        ROS_INFO_STREAM("map creation");
-        // get the map of parts
-        auto cam_map_o0 = cam.get_camera_map();
-        outside_time = ros::Time::now().toSec();
-        inside_time = ros::Time::now().toSec();
-        // Delay for list construction
-        ROS_INFO_STREAM("entering delay");
-        while (inside_time - outside_time < 5.0) {
-            inside_time = ros::Time::now().toSec();
-        }
-
-        for(auto &asmb: orders.at(0).assembly){
-          ROS_INFO_STREAM("[CURRRENT PROCESS]: " << asmb.shipment_type);
-
-          std::vector<Product> parts_for_assembly;
-          for (auto &part:asmb.products){
-            part.processed = false;
-            parts_for_assembly.push_back(part);
-          }
-
-          unsigned short int shipment_product_count(0);
-          std::string assembly_station = asmb.stations;
-
-          while(shipment_product_count <= asmb.products.size()){
-            if (shipment_product_count == asmb.products.size()){
-              break;
-            }
-
-
-
-            for(auto &iter: parts_for_assembly){
-              if(comp_class.high_priority_announced && !order1_done){
-          while(true){
-            auto temp_order_list = comp_class.get_order_list();
-            if(temp_order_list.size() > 1){
-              if (temp_order_list.at(1).kitting.size() > 0){
-              for(auto &kit1: temp_order_list.at(1).kitting){
-
-                ROS_INFO_STREAM("[CURRENT PROCESS order 1]: " << kit1.shipment_type);
-
-                // Create an empty list of parts for this kit
-                std::vector<Product> parts_for_kitting1;
-
-                // Push all the parts in kit to the list
-                for (auto &part:kit1.products){
-                  part.processed = false;
-                  parts_for_kitting1.push_back(part);
-                }
-
-                unsigned short int product_placed_in_shipment{0};
-
-                // Process the shipment
-                for(auto &iter: parts_for_kitting1){
-
-                  if (!iter.processed){
-                    // Find the required part from the map of parts
-                    auto p = cam_map.find(iter.type);
-                    // Search the part from the map
-                    for (int i{0}; i < p->second.size(); i++){
-                      // Check if the part is not already picked before, i.e., is present on bin
-                      if(p->second.at(i).status.compare("free") == 0){
-                        // Pick and place the part from bin to agv tray
-                        arm.movePart(iter.type, p->second.at(i).world_pose, iter.frame_pose, kit1.agv_id);
-                        // Update the status of the picked up part
-                        cam_map[iter.type].at(i).status = "processed";
-                        
-                        if (noblackout){
-                          // Get the data from quality control sensors	
-                          cam.query_faulty_cam();
-                          auto faulty_list = cam.get_faulty_part_list();
-                          
-                          double outside_time = ros::Time::now().toSec();
-                          double inside_time = ros::Time::now().toSec();
-                          // Delay for list construction
-                          ROS_INFO_STREAM("entering delay");
-                          
-                          while (inside_time - outside_time < 4.0) {
-                              inside_time = ros::Time::now().toSec();
-                          }
-                          
-                          // Check if part is faulty
-                          if (cam.faulty_part_list_.size() > 1){
-                            unsigned short int id{0};
-                            // if (cam.faulty_part_list_.at(0).faulty_cam_agv.compare(kit.agv_id) == 0){
-                            //   id = 0;
-                            // }
-                            // if (cam.faulty_part_list_.at(1).faulty_cam_agv.compare(kit.agv_id) == 0){
-                            //   id = 1;
-                            // }
-                            if (abs(cam.faulty_part_list_.at(0).world_pose.position.y - iter.world_pose.position.y) < 0.2 && abs(cam.faulty_part_list_.at(0).world_pose.position.x - iter.world_pose.position.x) < 0.2){
-                              id = 0;
-                            }
-                            if (abs(cam.faulty_part_list_.at(1).world_pose.position.y - iter.world_pose.position.y) < 0.2 && abs(cam.faulty_part_list_.at(1).world_pose.position.x - iter.world_pose.position.x) < 0.2){
-                              id = 1;
-                            }
-                            ROS_INFO_STREAM("part is faulty, removing it from the tray size 1");
-                            arm.pickfaulty(iter.type, cam.faulty_part_list_.at(id).world_pose);
-                            arm.goToPresetLocation("home2");
-                            arm.deactivateGripper();
-                            cam.query_faulty_cam();
-                            continue;
-                          }
-                          if (cam.faulty_part_list_.size() == 1){
-                            ROS_INFO_STREAM("part is faulty, removing it from the tray");
-                            arm.pickfaulty(iter.type, cam.faulty_part_list_.at(0).world_pose);
-                            arm.goToPresetLocation("home2");
-                            arm.deactivateGripper();
-                            cam.query_faulty_cam();
-                            continue;
-                          }
-                          iter.processed = true;
-                          break;
-                        }
-                        else{
-                          break;
-                        }
-                      } 
-                    }
-                  }
-                  product_placed_in_shipment++;
-                }
-                if(product_placed_in_shipment == kit1.products.size()){
-                  ros::Duration(sleep(1.0));
-                  motioncontrol::Agv agv{node, kit1.agv_id};
-                  if (agv.getAGVStatus()){
-                    agv.shipAgv(kit1.shipment_type, kit1.station_id);
-                  }
-                }
-              }}
-              // Order 1 kitting done
-
-              /// Order 1 Assembly
-              if (temp_order_list.at(1).assembly.size() > 0){
-                ROS_INFO_STREAM("inside order 1 Assembly");
-                double outside_time = ros::Time::now().toSec();
-                double inside_time = ros::Time::now().toSec();
-                while (inside_time - outside_time < 15.0) {
-                    inside_time = ros::Time::now().toSec();
-                }
-                
-                // find parts seen by logical cameras
-                ROS_INFO_STREAM("Finding parts");
-                auto list_o1p = cam.findparts();
-                ros::Duration(sleep(3.0));
-
-                ROS_INFO_STREAM("Seg list");
-                  
-                // Segregate parts and create the map of parts
-                cam.segregate_parts(list_o1p);
-                ros::Duration(sleep(3.0));
-                
-                ROS_INFO_STREAM("map creation");
-                // get the map of parts
-                auto cam_map_o1p = cam.get_camera_map();
-                outside_time = ros::Time::now().toSec();
-                inside_time = ros::Time::now().toSec();
-                // Delay for list construction
-                ROS_INFO_STREAM("entering delay");
-                while (inside_time - outside_time < 5.0) {
-                  inside_time = ros::Time::now().toSec();
-                }
-                
-
-                for(auto &asmb: temp_order_list.at(1).assembly){
-                  ROS_INFO_STREAM("[CURRRENT PROCESS]: " << asmb.shipment_type);
-
-                  std::vector<Product> parts_for_assembly;
-                  for (auto &part:asmb.products){
-                    part.processed = false;
-                    parts_for_assembly.push_back(part);
-                  }
-                  unsigned short int shipment_product_count(0);
-                  std::string assembly_station = asmb.stations;
-                  while(shipment_product_count <= asmb.products.size()){
-                    if (shipment_product_count == asmb.products.size()){
-                      break;
-                    }
-                    for(auto &iter: parts_for_assembly){
-                      // ROS_INFO_STREAM(iter.type);
-                      auto p = cam_map_o1p.find(iter.type);
-                      if (p != cam_map_o1p.end()){
-                        for (int i{0}; i < p->second.size(); i++){
-                          if (p->second.at(i).camera.find(assembly_station) != std::string::npos){
-                            ROS_INFO_STREAM("Moving the part: " << iter.type);
-                            gantry.move_gantry_to_assembly_station(p->second.at(i).camera);
-                            gantry.movePart(p->second.at(i).world_pose, iter.frame_pose, asmb.stations, iter.type);
-                            shipment_product_count++;
-                            break;
-                          }
-                        }
-                      }
-                    }
-                  }
-                  ros::Duration(sleep(1.0));
-                  as_submit_assembly(node, asmb.stations, asmb.shipment_type);
-                  if(( asmb.stations.compare("as2") == 0) || ( asmb.stations.compare("as4") == 0))
-                  {
-                    gantry.goToPresetLocation(gantry.home2_);
-                  }
-                  gantry.goToPresetLocation(gantry.home_);
-                  parts_for_assembly.clear();
-
-                }
-              }
-              order1_done = true;
-              break; 
-            }
-          }
-        }
-
-
-
-
-
-              // ROS_INFO_STREAM(iter.type);
-              auto p = cam_map_o0.find(iter.type);
-              if (p != cam_map_o0.end()){
-                for (int i{0}; i < p->second.size(); i++){
-                  if (p->second.at(i).camera.find(assembly_station) != std::string::npos){
-                    ROS_INFO_STREAM("Moving the part: " << iter.type);
-                    gantry.move_gantry_to_assembly_station(p->second.at(i).camera);
-                    gantry.movePart(p->second.at(i).world_pose, iter.frame_pose, asmb.stations, iter.type);
-                    shipment_product_count++;
-                    break;
-                  }
-                }
-              }
-            }
-          }
-          ros::Duration(sleep(1.0));
-          as_submit_assembly(node, asmb.stations, asmb.shipment_type);
-          gantry.goToPresetLocation(gantry.home_);
-          parts_for_assembly.clear();
-
-        }
-      } // Order 0 Assembly done
-      order0_done = true;
-      if (order1_done == true){
-        notfinished = false;
-      }
+  // Run the shipments of every order received, most urgent first
+  auto & scheduler = motioncontrol::OrderScheduler::instance();
+  Workcell cell{node, arm, gantry, cam, cam_map,
+    motioncontrol::PartIndex(cam_map, {motioncontrol::SensorId::kBins0, motioncontrol::SensorId::kBins1}),
+    empty_bins, {}, {}};
+  while(ros::ok()){
+    if(comp_class.getCompetitionState() == "done"){
+      break;
     }
-
-   
-    if (orders.size()>1 && !order1_done){
-      ROS_INFO_STREAM("Waiting for agv to reach the assembly station");
-      double outside_time = ros::Time::now().toSec();
-      double inside_time = ros::Time::now().toSec();
-      while (inside_time - outside_time < 30.0) {
-          inside_time = ros::Time::now().toSec();
+    if(auto task = scheduler.next()){
+      const bool done = task->kind == motioncontrol::ShipmentTask::Kind::kKitting ?
+        run_kitting(cell, *task) : run_assembly(cell, *task);
+      if(done){
+        scheduler.complete(task);
       }
-      // find parts seen by logical cameras
-      ROS_INFO_STREAM("Finding parts");
-      auto list = cam.findparts();
-      ROS_INFO_STREAM("Seg list"); 
-      // Segregate parts and create the map of parts
-      cam.segregate_parts(list);
-      ROS_INFO_STREAM("map creation");
-      // get the map of parts
-      auto cam_map = cam.get_camera_map();
-      outside_time = ros::Time::now().toSec();
-      inside_time = ros::Time::now().toSec();
-      // Delay for list construction
-      ROS_INFO_STREAM("entering delay");
-      while (inside_time - outside_time < 5.0) {
-          inside_time = ros::Time::now().toSec();
+      else{
+        scheduler.suspend(task);
       }
-      for(auto &asmb: orders.at(1).assembly){
-        ROS_INFO_STREAM("[CURRRENT PROCESS]: " << asmb.shipment_type);
-
-        std::vector<Product> parts_for_assembly;
-        for (auto &part:asmb.products){
-          part.processed = false;
-          parts_for_assembly.push_back(part);
-        }
-        unsigned short int shipment_product_count(0);
-        std::string assembly_station = asmb.stations;
-
-        for (int i{0}; i < cam_map.find("assembly_pump_blue")->second.size(); i++){
-            ROS_INFO_STREAM(cam_map.find("assembly_pump_blue")->second.at(i).camera);
-        }
-        for (int i{0}; i < cam_map.find("assembly_battery_green")->second.size(); i++){
-            ROS_INFO_STREAM(cam_map.find("assembly_battery_green")->second.at(i).camera);
-        }
-
-        while(shipment_product_count <= asmb.products.size()){
-          if (shipment_product_count == asmb.products.size()){
-            break;
-          }
-          
-          
-          // ROS_INFO_STREAM("SHIPMENT COUNT: " << shipment_product_count);
-          for(auto &iter: parts_for_assembly){
-            // ROS_INFO_STREAM(iter.type);
-            auto p = cam_map.find(iter.type);
-            if (p != cam_map.end()){
-              for (int i{0}; i < p->second.size(); i++){
-                if (p->second.at(i).camera.find(assembly_station) != std::string::npos){
-                  ROS_INFO_STREAM("Moving the part: " << iter.type);
-                  gantry.move_gantry_to_assembly_station(p->second.at(i).camera);
-                  gantry.movePart(p->second.at(i).world_pose, iter.frame_pose, asmb.stations, iter.type);
-                  shipment_product_count++;
-                  break;
-                }
-              }
-            }
-          }
-        }
-
-        ros::Duration(sleep(1.0));
-        as_submit_assembly(node, asmb.stations, asmb.shipment_type);
-        if(( asmb.stations.compare("as2") == 0) || ( asmb.stations.compare("as4") == 0))
-        {
-          gantry.goToPresetLocation(gantry.home2_);
-        }
-        gantry.goToPresetLocation(gantry.home_);
-        parts_for_assembly.clear();
-      }
-      order1_done = true;
-      notfinished = false;
+      continue;
+    }
+    // taken before the wait, so an order arriving in between is seen below
+    const auto orders = comp_class.get_orders();
+    if(scheduler.waitForWork(ros::Time::now() + kOrderPoll) || orders->value.empty()){
+      continue;
+    }
+    // Every order received is done, give a later one some time to come
+    if(comp_class.order_store().waitForChange(orders->version, ros::Time::now() + kLastOrderWait)->version == orders->version){
+      break;
     }
-    
-  }
-
-
-  if(comp_class.getCompetitionState() == "done"){
-    comp_class.endCompetition();
-  }
-
-  if(!notfinished){
-    ros::shutdown();
   }
 
-  }
+  comp_class.endCompetition();
+  ros::shutdown();
   ros::waitForShutdown();  
+  motioncontrol::SensorRecorder::instance().stop();
 }
@@ -11,7 +11,22 @@
 #include <Eigen/Geometry>
 #include <tf2/convert.h>
 #include "../include/util/util.h"
+#include "../include/camera/belt_tracker.h"
+#include "../include/camera/bin_slots.h"
+#include "../include/util/sim_clock.h"
 #include <math.h>
+#include <algorithm>
+
+namespace {
+    // bins next to the rail of the kitting arm, where it stages parts
+    const std::vector<int> kStagingBins{ 1, 2, 5, 6 };
+    // farthest the gripper moves upstream along the belt to meet a part, in meters
+    const double kInterceptRange = 1.0;
+    // time assumed for the base to move to the intercept point, in seconds
+    const double kBaseMoveTime = 1.5;
+    // distance from the bin center, along -y, at which a part is flipped, tuned in simulation
+    const double kFlipOffset = 0.25;
+}
 
 namespace motioncontrol {
     /////////////////////////////////////////////////////
@@ -69,25 +84,7 @@ namespace motioncontrol {
         double wrist_2_joint{ -1.51 };
         double wrist_3_joint{ 0 };
 
-        //home position
-        home1_.arm_preset = { 0, 0, -1.25, 1.74, -2.04, -1.57, 0 };
-        home1_.name = "home1";
-        home2_.arm_preset = { 0, -M_PI, -1.25, 1.74, -2.04, -1.57, 0 };
-        home2_.name = "home2";
-        on_.arm_preset = { 1.76 , 0, -0.74, 1.76, 5.28, 0, 0 };
-        on_.name = "on"; 
-        above_.arm_preset = { 1.76 , 0, -1.62, 1.76, 6.28, 0, 0.0 };
-        above_.name = "above";
-        agv1_.arm_preset = { 3.83, -M_PI, -1.25, 1.74, -2.04, -1.57, 0 };
-        agv1_.name = "agv1";
-        agv2_.arm_preset = { 0.83, -M_PI, -1.25, 1.74, -2.04, -1.57, 0 };
-        agv2_.name = "agv2";
-        agv3_.arm_preset = { -1.83, -M_PI, -1.25, 1.74, -2.04, -1.57, 0 };
-        agv3_.name = "agv3";
-        agv4_.arm_preset = { -4.33, -M_PI, -1.25, 1.74, -2.04, -1.57, 0 };
-        agv4_.name = "agv4";
-        flip_.arm_preset = { -3.97, 0, -2.54, -2.0, 4.56, 0, 0};
-        flip_.name = "flip";
+        // preset locations are in motioncontrol::Registry::arm_presets
         // bin1_.arm_preset = { 3.2 , 1.51 , -1.12 , 1.76, -2.04, -1.57, 0 };
         // bin1_.name = "bin1";
 
@@ -127,9 +124,7 @@ namespace motioncontrol {
         auto init_pose_in_world = pose_in_world_frame;
 
         // ROS_INFO_STREAM(init_pose_in_world.position.x << " " << init_pose_in_world.position.y);
-        // auto target_pose_in_world = motioncontrol::transformtoWorldFrame(goal_in_tray_frame, agv);
-        auto target_pose_in_world = motioncontrol::gettransforminWorldFrame(goal_in_tray_frame, agv);
-        
+        // the target is resolved in the world frame by placePart
         if (pickPart(part_type, init_pose_in_world)) {
             placePart(init_pose_in_world, goal_in_tray_frame, agv);
         }
@@ -137,8 +132,16 @@ namespace motioncontrol {
     /////////////////////////////////////////////////////
     nist_gear::VacuumGripperState Arm::getGripperState()
     {
+        std::lock_guard<std::mutex> lock(gripper_mutex_);
         return gripper_state_;
     }
+    /////////////////////////////////////////////////////
+    bool Arm::waitForAttached(const ros::Time& deadline)
+    {
+        std::unique_lock<std::mutex> lock(gripper_mutex_);
+        return SimClock::instance().waitUntil(gripper_changed_, lock, deadline,
+            [this] { return static_cast<bool>(gripper_state_.attached); });
+    }
 
     /**
      * @brief Pick up a part from a bin
@@ -210,7 +213,7 @@ namespace motioncontrol {
         // activate gripper
         // sometimes it does not activate right away
         // so we are doing this in a loop
-        while (!gripper_state_.enabled) {
+        while (!getGripperState().enabled) {
             activateGripper();
         }
 
@@ -234,20 +237,20 @@ namespace motioncontrol {
         plan.trajectory_ = trajectory;
         arm_group_.execute(plan);
 
-        ros::Duration(sleep(2.0));
+        waitForAttached(ros::Time::now() + ros::Duration(2.0));
 
         // move the arm 1 mm down until the part is attached
-        while (!gripper_state_.attached) {
+        while (!getGripperState().attached) {
             grasp_pose.position.z -= 0.001;
             arm_group_.setPoseTarget(grasp_pose);
             arm_group_.move();
-            ros::Duration(sleep(0.5));
+            waitForAttached(ros::Time::now() + ros::Duration(0.5));
         }
         
             arm_group_.setMaxVelocityScalingFactor(1.0);
             arm_group_.setMaxAccelerationScalingFactor(1.0);
             ROS_INFO_STREAM("[Gripper] = object attached");
-            ros::Duration(sleep(2.0));
+            ros::Duration(2.0).sleep();
             arm_group_.setPoseTarget(postgrasp_pose3);
             arm_group_.move();
 
@@ -307,19 +310,19 @@ namespace motioncontrol {
         arm_group_.setMaxVelocityScalingFactor(1);
         arm_group_.setPoseTarget(arm_ee_link_pose);
         arm_group_.move();
-        ros::Duration(sleep(0.5));
+        ros::Duration(0.5).sleep();
         
         arm_ee_link_pose.position.z = arm_ee_link_pose.position.z - 0.1;
         ROS_INFO_STREAM("EE_Z " <<arm_ee_link_pose.position.z);
         arm_group_.setMaxVelocityScalingFactor(1);
         arm_group_.setPoseTarget(arm_ee_link_pose);
         arm_group_.move();
-        ros::Duration(sleep(0.5));
+        ros::Duration(0.5).sleep();
 
         // // activate gripper
         // // sometimes it does not activate right away
         // // so we are doing this in a loop
-        while (!gripper_state_.enabled) {
+        while (!getGripperState().enabled) {
             activateGripper();
         }
 
@@ -331,20 +334,20 @@ namespace motioncontrol {
         */
 
         // move the arm 1 mm down until the part is attached
-        while (!gripper_state_.attached) {
+        while (!getGripperState().attached) {
             arm_ee_link_pose.position.z = arm_ee_link_pose.position.z - 0.001;
             ROS_INFO_STREAM("EE_Z in loop " <<arm_ee_link_pose.position.z);
             arm_group_.setMaxVelocityScalingFactor(1);
             arm_group_.setPoseTarget(arm_ee_link_pose);
             arm_group_.move();
-            ros::Duration(sleep(0.5));
+            waitForAttached(ros::Time::now() + ros::Duration(0.5));
         }
             arm_ee_link_pose = arm_group_.getCurrentPose().pose;
              arm_ee_link_pose.position.z = arm_ee_link_pose.position.z + 0.5;
             arm_group_.setMaxVelocityScalingFactor(1.0);
             // arm_group_.setMaxAccelerationScalingFactor(1.0);
             ROS_INFO_STREAM("[Gripper] = object attached");
-            ros::Duration(sleep(2.0));
+            ros::Duration(2.0).sleep();
             // geometry_msgs::Pose arm_ee_link_pose1 = arm_group_.getCurrentPose().pose;
             // arm_ee_link_pose.position.z += 0.5;
             arm_group_.setPoseTarget(arm_ee_link_pose);
@@ -358,9 +361,12 @@ namespace motioncontrol {
     {
         goToPresetLocation(agv);
         // get the target pose of the part in the world frame
-        auto target_pose_in_world = motioncontrol::transformtoWorldFrame(
-            part_pose_in_frame,
-            agv);
+        geometry_msgs::Pose target_pose_in_world;
+        if (!motioncontrol::transformtoWorldFrame(part_pose_in_frame, agv,
+            ros::Time::now() + motioncontrol::kTransformTimeout, target_pose_in_world)) {
+            ROS_ERROR_STREAM("[Arm] target pose in " << agv << " not available");
+            return false;
+        }
 
         // moveBaseTo(target_pose_in_world.position.y - 0.1);
         geometry_msgs::Pose arm_ee_link_pose = arm_group_.getCurrentPose().pose;
@@ -427,7 +433,7 @@ namespace motioncontrol {
         deactivateGripper();
 
         arm_group_.setMaxVelocityScalingFactor(1.0);
-        goToPresetLocation("home2");
+        goToPresetLocation(ArmPreset::kHome2);
 
         return true;
         
@@ -435,7 +441,11 @@ namespace motioncontrol {
     /////////////////////////////////////////////////////
     void Arm::gripper_state_callback(const nist_gear::VacuumGripperState::ConstPtr& gripper_state_msg)
     {
-        gripper_state_ = *gripper_state_msg;
+        {
+            std::lock_guard<std::mutex> lock(gripper_mutex_);
+            gripper_state_ = *gripper_state_msg;
+        }
+        gripper_changed_.notify_all();
     }
     /////////////////////////////////////////////////////
     void Arm::activateGripper()
@@ -460,42 +470,18 @@ namespace motioncontrol {
     /////////////////////////////////////////////////////
     void Arm::goToPresetLocation(std::string location_name)
     {
-
-        ArmPresetLocation location;
-        if (location_name.compare("home1") == 0) {
-            location = home1_;
-        }
-        else if (location_name.compare("home2") == 0) {
-            location = home2_;
+        ArmPreset preset;
+        if (!armPresetFromName(location_name, preset)) {
+            ROS_ERROR_STREAM("[Arm] unknown preset location " << location_name);
+            return;
         }
-        else if (location_name.compare("on") == 0) {
-            location = on_;
-        }
-        else if (location_name.compare("above") == 0) {
-            location = above_;
-        }
-        else if (location_name.compare("agv1") == 0) {
-            location = agv1_;
-        }
-        else if (location_name.compare("agv2") == 0) {
-            location = agv2_;
-        }
-        else if (location_name.compare("agv3") == 0) {
-            location = agv3_;
-        }
-        else if (location_name.compare("agv4") == 0) {
-            location = agv4_;
-        }
-        else if (location_name.compare("flip") == 0) {
-            location = flip_;
-        }
-        joint_group_positions_.at(0) = location.arm_preset.at(0);
-        joint_group_positions_.at(1) = location.arm_preset.at(1);
-        joint_group_positions_.at(2) = location.arm_preset.at(2);
-        joint_group_positions_.at(3) = location.arm_preset.at(3);
-        joint_group_positions_.at(4) = location.arm_preset.at(4);
-        joint_group_positions_.at(5) = location.arm_preset.at(5);
-        joint_group_positions_.at(6) = location.arm_preset.at(6);
+        goToPresetLocation(preset);
+    }
+
+    void Arm::goToPresetLocation(ArmPreset preset)
+    {
+        const auto& joints = armPresetInfo(preset).joints;
+        joint_group_positions_.assign(joints.begin(), joints.end());
 
         arm_group_.setJointValueTarget(joint_group_positions_);
 
@@ -506,94 +492,56 @@ namespace motioncontrol {
             arm_group_.move();
     }
 
-    geometry_msgs::Pose Arm::get_part_pose_in_empty_bin(int bin_number){
-        std::array<double,3> bin_origin{0,0,0};
-        geometry_msgs::Pose part_world_pose;
-        ROS_INFO_STREAM("empty_bin_place_count "<<empty_bin_place_count);
-        if (bin_number == 1){
-            bin_origin = bin1_origin_;
-        }
-        if (bin_number == 2){
-            bin_origin = bin2_origin_;
-        }
-        if (bin_number == 3){
-            bin_origin = bin3_origin_;
-        }
-        if (bin_number == 4){
-            bin_origin = bin4_origin_;
-        }
-        if (bin_number == 5){
-            bin_origin = bin5_origin_;
-        }
-        if (bin_number == 6){
-            bin_origin = bin6_origin_;
-        }
-        if (bin_number == 7){
-            bin_origin = bin7_origin_;
-        }
-        if (bin_number == 8){
-            bin_origin = bin8_origin_;
-        }
-
-        if (empty_bin_place_count == 0){
-            part_world_pose.position.x = bin_origin.at(0) + 0.20;
-            part_world_pose.position.y = bin_origin.at(1) - 0.15;
-            part_world_pose.position.z = bin_origin.at(2);
-            empty_bin_place_count++;
-        }
-        else if (empty_bin_place_count == 1){
-            part_world_pose.position.x = bin_origin.at(0) + 0.20;
-            part_world_pose.position.y = bin_origin.at(1) + 0.15;
-            part_world_pose.position.z = bin_origin.at(2);
-            empty_bin_place_count++;
-        }
-        else if (empty_bin_place_count == 2){
-            part_world_pose.position.x = bin_origin.at(0) - 0.10;
-            part_world_pose.position.y = bin_origin.at(1) + 0.15;
-            part_world_pose.position.z = bin_origin.at(2);
-            empty_bin_place_count++;
-        }
-        else if (empty_bin_place_count == 3){
-            part_world_pose.position.x = bin_origin.at(0) - 0.10;
-            part_world_pose.position.y = bin_origin.at(1) - 0.15;
-            part_world_pose.position.z = bin_origin.at(2);
-        }
-        return part_world_pose;
-    }
-
     std::vector<int>  Arm::pick_from_conveyor(std::vector<int> empty_bins_at_start, unsigned short int n)
     {   
-        std::vector<int> empty_bins;
-        int bin_selected = 0;
-        for(auto &bin: empty_bins_at_start){
-            ROS_INFO_STREAM("bin number "<< bin);
-            if(bin == 1 || bin == 2 || bin == 5 || bin == 6)
-            {
-                bin_selected = bin;
-                break;
+        std::vector<int> used_bins;
+        auto& belt = BeltTracker::instance();
+        unsigned short int picked = 0;
+        while (picked < n && ros::ok()) {
+            goToPresetLocation(ArmPreset::kOn);
+            geometry_msgs::Pose arm_ee_link_pose = arm_group_.getCurrentPose().pose;
+            auto side_orientation = motioncontrol::quaternionFromEuler(0, 0, 1.57);
+            while (!getGripperState().enabled) {
+                activateGripper();
             }
-        }
 
-        for(auto &bin: empty_bins_at_start){
-            if(bin == bin_selected){
-                continue;
+            // wait for the tracker to predict the next part at the gripper
+            ros::Time arrival;
+            Product part;
+            if (!belt.waitForArrival(arm_ee_link_pose.position.y, ros::Time::now() + kBeltTimeout, arrival, part)) {
+                ROS_INFO_STREAM("[Arm] no part coming on the conveyor belt");
+                break;
             }
-            else{
-                empty_bins.push_back(bin);
+
+            // move upstream to meet a part that is still far away
+            double meet_y;
+            if ((arrival - ros::Time::now()).toSec() > 2 * kBaseMoveTime &&
+                belt.predict(part.id, ros::Time::now() + ros::Duration(kBaseMoveTime), meet_y)) {
+                const double offset = meet_y - arm_ee_link_pose.position.y;
+                meet_y = arm_ee_link_pose.position.y + std::max(-kInterceptRange, std::min(kInterceptRange, offset));
+                arm_group_.getCurrentState()->copyJointGroupPositions(
+                    arm_group_.getCurrentState()->getJointModelGroup("kitting_arm"), joint_group_positions_);
+                moveBaseTo(joint_group_positions_.at(0) + meet_y - arm_ee_link_pose.position.y);
+                if (!belt.waitForArrival(meet_y, ros::Time::now() + kBeltTimeout, arrival, part)) {
+                    ROS_WARN_STREAM("[Arm] " << part.id << " not predicted at the intercept point, trying again");
+                    continue;
+                }
             }
-        }
-        for(int i = 0 ; i < n; i++){
-            double trigger_time_ = ros::Time::now().toSec();
-            
-            goToPresetLocation("on");
-            geometry_msgs::Pose arm_ee_link_pose = arm_group_.getCurrentPose().pose;
-            auto side_orientation = motioncontrol::quaternionFromEuler(0, 0, 1.57);
-            while (!gripper_state_.enabled) {
-                activateGripper();
+            ROS_INFO_STREAM("[Arm] " << part.type << " expected at the gripper in " << (arrival - ros::Time::now()).toSec() << " s");
+
+            // reserve the free staging slot closest to the gripper before taking the part off the belt
+            int bin_selected = 0;
+            geometry_msgs::Pose bin;
+            if (!BinSlots::instance().allocate(part.type, arm_ee_link_pose.position, kStagingBins, bin_selected, bin)) {
+                ROS_WARN_STREAM("[Arm] no free slot in the staging bins for " << part.type << ", leaving it on the conveyor belt");
+                break;
             }
-            while (!gripper_state_.attached && ros::Time::now().toSec() - trigger_time_ < 15){
-                
+            if (!waitForAttached(arrival + kInterceptSlack)) {
+                ROS_WARN_STREAM("[Arm] missed " << part.id << " on the conveyor belt");
+                continue;
             }
+            belt.picked(part.id);
+            picked++;
             ROS_INFO_STREAM("object attached"); 
             // arm_ee_link_pose.position.z = arm_ee_link_pose.position.z + 0.009;
             side_orientation = motioncontrol::quaternionFromEuler(0, 0, 0);
@@ -606,12 +554,15 @@ namespace motioncontrol {
             arm_group_.setPoseTarget(arm_ee_link_pose);
             arm_group_.move();
             
+            // stage the part in the slot reserved for it
+            if (std::find(used_bins.begin(), used_bins.end(), bin_selected) == used_bins.end())
+                used_bins.push_back(bin_selected);
             ROS_INFO_STREAM("Selected bin number "<< bin_selected);
-            geometry_msgs::Pose bin = get_part_pose_in_empty_bin(bin_selected);
             ROS_INFO_STREAM("Y_pos: "<< bin.position.y);
             side_orientation = motioncontrol::quaternionFromEuler(0, 0, 0);
             moveBaseTo(bin.position.y);
-            arm_ee_link_pose.position.x = bin.position.x - 0.15;
+            // release over the reserved slot, the footprint BinSlots checked
+            arm_ee_link_pose.position.x = bin.position.x;
             arm_ee_link_pose.position.y = bin.position.y;
             arm_ee_link_pose.position.z = bin.position.z + 0.5;
             arm_group_.setMaxVelocityScalingFactor(1.0);
@@ -639,29 +590,45 @@ namespace motioncontrol {
 
             ros::Duration(2.0).sleep();
             deactivateGripper();
-            goToPresetLocation("above");
+            goToPresetLocation(ArmPreset::kAbove);
         }
         // goToPresetLocation(bin);
+        std::vector<int> empty_bins;
+        for (auto bin: empty_bins_at_start){
+            if (std::find(used_bins.begin(), used_bins.end(), bin) == used_bins.end())
+                empty_bins.push_back(bin);
+        }
         return empty_bins;
     }
     ///////////////////////////////
-    void Arm::flippart(Product part, std::vector<int> empty_bins, geometry_msgs::Pose part_pose_in_frame, std::string agv, bool arm_required){
-        std::string part_type = part.type;
-        geometry_msgs::Pose part_pose = part.world_pose;
-        ROS_INFO_STREAM("In flip");
-        
-        int bin_selected = 0;
-        for(auto &bin: empty_bins){
-            ROS_INFO_STREAM("bin number "<< bin);
-            if(bin == 1 || bin == 2 || bin == 5 || bin == 6)
-            {
-                bin_selected = bin;
-                break;
+    bool Arm::reserveFlipSpot(PartType type, const std::vector<int>& empty_bins, int& bin)
+    {
+        // in an empty bin first, then in any staging bin it still fits in
+        std::vector<int> candidates;
+        for (auto empty : empty_bins) {
+            if (std::find(kStagingBins.begin(), kStagingBins.end(), empty) != kStagingBins.end())
+                candidates.push_back(empty);
+        }
+        candidates.insert(candidates.end(), kStagingBins.begin(), kStagingBins.end());
+        // a part flipped at kFlipOffset hangs over the bin edge, the part of its footprint inside the bin is reserved
+        const double inside = std::min(kFlipOffset, BinSlots::kBinHalfSide - BinSlots::footprint(type));
+        for (auto candidate : candidates) {
+            auto spot = BinSlots::center(candidate);
+            spot.y -= inside;
+            if (BinSlots::instance().reserve(candidate, spot, type)) {
+                bin = candidate;
+                return true;
             }
         }
-        if(bin_selected == 0){
-            bin_selected = 2;
-        }
+        ROS_WARN_STREAM("[Arm] no room to flip " << type << " in the staging bins");
+        return false;
+    }
+    ///////////////////////////////
+    void Arm::flippart(Product part, int bin_selected, geometry_msgs::Pose part_pose_in_frame, std::string agv, bool arm_required){
+        std::string part_type = part.type;
+        geometry_msgs::Pose part_pose = part.world_pose;
+        const double offset = kFlipOffset;
+        ROS_INFO_STREAM("In flip, bin number " << bin_selected);
         
         std::array<double,3> bin_origin{0,0,0};
         geometry_msgs::Pose part_world_pose;
@@ -702,7 +669,7 @@ namespace motioncontrol {
         arm_ee_link_pose.orientation.z = flat_orientation.getZ();
         arm_ee_link_pose.orientation.w = flat_orientation.getW();
         arm_ee_link_pose.position.x = bin_origin.at(0);
-        arm_ee_link_pose.position.y = bin_origin.at(1)-0.25 ;
+        arm_ee_link_pose.position.y = bin_origin.at(1) - offset;
         arm_ee_link_pose.position.z = bin_origin.at(2)+0.15;
         arm_group_.setMaxVelocityScalingFactor(1.0);
         arm_group_.setPoseTarget(arm_ee_link_pose);
@@ -755,7 +722,7 @@ namespace motioncontrol {
         arm_group_.setMaxVelocityScalingFactor(1.0);
         arm_group_.setPoseTarget(arm_ee_link_pose);
         arm_group_.move();
-        // goToPresetLocation("flip");
+        // goToPresetLocation(ArmPreset::kFlip);
         auto side_orientation = motioncontrol::quaternionFromEuler(0, 0, -1.57);
         arm_ee_link_pose.orientation.x = side_orientation.getX();
         arm_ee_link_pose.orientation.y = side_orientation.getY();
@@ -766,7 +733,7 @@ namespace motioncontrol {
         arm_group_.setPoseTarget(arm_ee_link_pose);
         arm_group_.move();
         
-        while (!gripper_state_.enabled) {
+        while (!getGripperState().enabled) {
             activateGripper();
         }
         
@@ -778,11 +745,11 @@ namespace motioncontrol {
         arm_group_.move();
         
 
-        while (!gripper_state_.attached) {
+        while (!getGripperState().attached) {
             arm_ee_link_pose.position.y -= 0.005;
             arm_group_.setPoseTarget(arm_ee_link_pose);
             arm_group_.move();
-            ros::Duration(sleep(0.5));
+            waitForAttached(ros::Time::now() + ros::Duration(0.5));
         }
 
         arm_ee_link_pose.position.z =arm_ee_link_pose.position.z+0.15;
@@ -820,7 +787,7 @@ namespace motioncontrol {
         part.world_pose.orientation.y = final_orientation.getY();
         part.world_pose.orientation.z = final_orientation.getZ();
         part.world_pose.orientation.w = final_orientation.getW();
-        goToPresetLocation("home2");
+        goToPresetLocation(ArmPreset::kHome2);
         movePart(part_type,part.world_pose,part_pose_in_frame, agv);
 
     }
@@ -1234,9 +1201,12 @@ namespace gantry_motioncontrol {
         ROS_INFO_STREAM("full: " << full_gantry_group_.getCurrentPose().pose.orientation);
 
         // get the target pose of the part in the world frame
-        auto target_in_world_frame = motioncontrol::transformtoWorldFrame(
-            target_pose_in_frame,
-            location);
+        geometry_msgs::Pose target_in_world_frame;
+        if (!motioncontrol::transformtoWorldFrame(target_pose_in_frame, location,
+            ros::Time::now() + motioncontrol::kTransformTimeout, target_in_world_frame)) {
+            ROS_ERROR_STREAM("[Gantry] target pose in " << location << " not available");
+            return false;
+        }
 
         if (location == "agv1") {
             goToPresetLocation(home_);
@@ -1344,9 +1314,12 @@ namespace gantry_motioncontrol {
             part_init_pose_in_world.orientation.w);
 
         // get the target pose of the part in the world frame
-        auto target_in_world_frame = motioncontrol::transformtoWorldFrame(
-            target_pose_in_frame,
-            location);
+        geometry_msgs::Pose target_in_world_frame;
+        if (!motioncontrol::transformtoWorldFrame(target_pose_in_frame, location,
+            ros::Time::now() + motioncontrol::kTransformTimeout, target_in_world_frame)) {
+            ROS_ERROR_STREAM("[Gantry] target pose in " << location << " not available");
+            return false;
+        }
 
         // orientation of the part in the tray, in world frame
         tf2::Quaternion q_target_part(
@@ -1920,8 +1893,8 @@ namespace gantry_motioncontrol {
             arm_ee_link_pose.position.y -= 0.005;
             arm_gantry_group_.setPoseTarget(arm_ee_link_pose);
             arm_gantry_group_.move();
+            waitForAttached(ros::Time::now() + ros::Duration(0.5));
             state = getGripperState();
-            ros::Duration(sleep(0.5));
         }
 
         arm_ee_link_pose.position.z = arm_ee_link_pose.position.z + 0.12;
@@ -2025,7 +1998,7 @@ namespace gantry_motioncontrol {
 
             }
             
-            ROS_INFO_STREAM(part.bin_number);
+            ROS_INFO_STREAM(static_cast<int>(part.bin_number));
             goToPresetLocation(home_);
             ROS_INFO_STREAM("Home reached");
             ros::Duration(2.0).sleep();
@@ -2129,9 +2102,18 @@ namespace gantry_motioncontrol {
     /////////////////////////////////////////////////////
     nist_gear::VacuumGripperState Gantry::getGripperState()
     {
+        std::lock_guard<std::mutex> lock(gripper_mutex_);
         return gantry_gripper_state_;
     }
 
+    /////////////////////////////////////////////////////
+    bool Gantry::waitForAttached(const ros::Time& deadline)
+    {
+        std::unique_lock<std::mutex> lock(gripper_mutex_);
+        return motioncontrol::SimClock::instance().waitUntil(gripper_changed_, lock, deadline,
+            [this] { return static_cast<bool>(gantry_gripper_state_.attached); });
+    }
+
     /////////////////////////////////////////////////////
     void Gantry::goToPresetLocation(GantryPresetLocation location, bool full_robot)
     {
@@ -2183,7 +2165,11 @@ namespace gantry_motioncontrol {
     /////////////////////////////////////////////////////
     void Gantry::gantry_gripper_state_callback(const nist_gear::VacuumGripperState::ConstPtr& gripper_state_msg)
     {
-        gantry_gripper_state_ = *gripper_state_msg;
+        {
+            std::lock_guard<std::mutex> lock(gripper_mutex_);
+            gantry_gripper_state_ = *gripper_state_msg;
+        }
+        gripper_changed_.notify_all();
     }
 
     /////////////////////////////////////////////////////
@@ -0,0 +1,248 @@
+#include "../include/camera/belt_tracker.h"
+#include "../include/util/transform_service.h"
+#include "../include/util/sim_clock.h"
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+namespace motioncontrol {
+
+    namespace {
+        // time allowed to look up the pose of a breakbeam
+        const ros::Duration kBeamLookupTimeout(0.5);
+    }  // namespace
+
+    constexpr double BeltTracker::kGate;
+    constexpr double BeltTracker::kVelocitySmoothing;
+    constexpr int BeltTracker::kMissedFrames;
+    constexpr double BeltTracker::kCoastTime;
+    constexpr double BeltTracker::kMinInterval;
+
+    BeltTracker& BeltTracker::instance()
+    {
+        static BeltTracker tracker;
+        return tracker;
+    }
+
+    double BeltTracker::predicted(const Track& track, const ros::Time& stamp) const
+    {
+        return track.y + velocity_ * (stamp - track.stamp).toSec();
+    }
+
+    void BeltTracker::correct(Track& track, double y, const ros::Time& stamp)
+    {
+        const double dt = (stamp - track.stamp).toSec();
+        if (dt >= kMinInterval) {
+            const double measured = (y - track.y) / dt;
+            velocity_ = velocity_known_ ? (1 - kVelocitySmoothing) * velocity_ + kVelocitySmoothing * measured : measured;
+            velocity_known_ = true;
+        }
+        track.y = y;
+        track.stamp = stamp;
+        track.missed = 0;
+    }
+
+    void BeltTracker::observe(const ros::Time& stamp, const std::vector<Product>& detections)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // candidate pairs within the gate, closest first; a track of unknown type matches any type
+        std::vector<std::tuple<double, Track*, std::size_t> > pairs;
+        for (auto& entry : tracks_) {
+            auto& track = entry.second;
+            const double y = predicted(track, stamp);
+            for (std::size_t d = 0; d < detections.size(); d++) {
+                if (!track.part.type.empty() && track.part.type != detections[d].type)
+                    continue;
+                const double dx = track.part.type.empty() ? 0 : track.part.world_pose.position.x - detections[d].world_pose.position.x;
+                const double dy = y - detections[d].world_pose.position.y;
+                const double distance = dx * dx + dy * dy;
+                if (distance <= kGate * kGate)
+                    pairs.emplace_back(distance, &track, d);
+            }
+        }
+        std::sort(pairs.begin(), pairs.end(),
+            [](const std::tuple<double, Track*, std::size_t>& a, const std::tuple<double, Track*, std::size_t>& b) {
+                return std::get<0>(a) < std::get<0>(b);
+            });
+
+        std::vector<bool> detection_matched(detections.size(), false);
+        std::map<const Track*, bool> track_matched;
+        for (const auto& pair : pairs) {
+            Track* track = std::get<1>(pair);
+            const std::size_t d = std::get<2>(pair);
+            if (detection_matched[d] || track_matched[track])
+                continue;
+            detection_matched[d] = true;
+            track_matched[track] = true;
+            const std::uint32_t id = track->part.id;
+            track->part = detections[d];
+            track->part.id = id;
+            correct(*track, detections[d].world_pose.position.y, stamp);
+        }
+
+        for (std::size_t d = 0; d < detections.size(); d++) {
+            const double y = detections[d].world_pose.position.y;
+            if (!view_known_) {
+                view_min_y_ = view_max_y_ = y;
+                view_known_ = true;
+            }
+            view_min_y_ = std::min(view_min_y_, y);
+            view_max_y_ = std::max(view_max_y_, y);
+            if (detection_matched[d])
+                continue;
+            Track track;
+            track.part = detections[d];
+            track.part.id = next_id_++;
+            track.y = y;
+            track.stamp = stamp;
+            tracks_.emplace(track.part.id, track);
+        }
+
+        // a part the camera should see but does not
+        for (auto& entry : tracks_) {
+            auto& track = entry.second;
+            if (track_matched[&track] || track.stamp == stamp)
+                continue;
+            const double y = predicted(track, stamp);
+            if (view_known_ && y >= view_min_y_ && y <= view_max_y_)
+                track.missed++;
+        }
+        expire(stamp);
+        changed_.notify_all();
+    }
+
+    void BeltTracker::breakbeam(const std::string& frame, const ros::Time& stamp)
+    {
+        double beam_y;
+        if (!beamPosition(frame, beam_y))
+            return;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        Track* closest = nullptr;
+        double best = kGate;
+        for (auto& entry : tracks_) {
+            const double distance = std::abs(predicted(entry.second, stamp) - beam_y);
+            if (distance <= best) {
+                best = distance;
+                closest = &entry.second;
+            }
+        }
+        if (closest) {
+            if (closest->beam == frame)
+                return;
+            correct(*closest, beam_y, stamp);
+            closest->beam = frame;
+        }
+        else {
+            Track track;
+            track.part.id = next_id_++;
+            track.part.world_pose.position.y = beam_y;
+            track.part.time_stamp = stamp;
+            track.y = beam_y;
+            track.stamp = stamp;
+            track.beam = frame;
+            tracks_.emplace(track.part.id, track);
+        }
+        expire(stamp);
+        changed_.notify_all();
+    }
+
+    bool BeltTracker::beamPosition(const std::string& frame, double& y)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto beam = beams_.find(frame);
+            if (beam != beams_.end()) {
+                y = beam->second;
+                return true;
+            }
+        }
+        geometry_msgs::TransformStamped world_beam_tf;
+        if (!TransformService::instance().waitForTransform("world", frame, ros::Time::now() + kBeamLookupTimeout, world_beam_tf)) {
+            ROS_WARN_STREAM("[BeltTracker] no pose for breakbeam " << frame);
+            return false;
+        }
+        y = world_beam_tf.transform.translation.y;
+        std::lock_guard<std::mutex> lock(mutex_);
+        beams_[frame] = y;
+        return true;
+    }
+
+    void BeltTracker::expire(const ros::Time& stamp)
+    {
+        for (auto entry = tracks_.begin(); entry != tracks_.end();) {
+            const auto& track = entry->second;
+            if (track.missed >= kMissedFrames || (stamp - track.stamp).toSec() > kCoastTime)
+                entry = tracks_.erase(entry);
+            else
+                ++entry;
+        }
+    }
+
+    double BeltTracker::velocity() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return velocity_;
+    }
+
+    bool BeltTracker::arrivalOf(const Track& track, double pick_y, ros::Time& arrival) const
+    {
+        if (!velocity_known_ || velocity_ == 0)
+            return false;
+        const double travel = (pick_y - track.y) / velocity_;
+        if (travel < 0)
+            return false;
+        arrival = track.stamp + ros::Duration(travel);
+        return true;
+    }
+
+    bool BeltTracker::nextArrival(double pick_y, const ros::Time& after, ros::Time& arrival, Product& part) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return firstArrival(pick_y, after, arrival, part);
+    }
+
+    bool BeltTracker::firstArrival(double pick_y, const ros::Time& after, ros::Time& arrival, Product& part) const
+    {
+        bool found = false;
+        for (const auto& entry : tracks_) {
+            ros::Time when;
+            if (!arrivalOf(entry.second, pick_y, when) || when < after)
+                continue;
+            if (!found || when < arrival) {
+                arrival = when;
+                part = entry.second.part;
+                found = true;
+            }
+        }
+        if (found) {
+            part.world_pose.position.y = pick_y;
+            part.time_stamp = arrival;
+        }
+        return found;
+    }
+
+    bool BeltTracker::waitForArrival(double pick_y, const ros::Time& deadline, ros::Time& arrival, Product& part) const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return SimClock::instance().waitUntil(changed_, lock, deadline,
+            [&] { return firstArrival(pick_y, ros::Time::now(), arrival, part); });
+    }
+
+    bool BeltTracker::predict(std::uint32_t id, const ros::Time& stamp, double& y) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto track = tracks_.find(id);
+        if (track == tracks_.end())
+            return false;
+        y = predicted(track->second, stamp);
+        return true;
+    }
+
+    void BeltTracker::picked(std::uint32_t id)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tracks_.erase(id);
+    }
+}  // namespace motioncontrol
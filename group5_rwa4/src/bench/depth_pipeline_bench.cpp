@@ -0,0 +1,179 @@
+/**
+ * @file depth_pipeline_bench.cpp
+ * @brief Frame rate and accuracy of the depth camera part localization
+ *
+ * Renders synthetic clouds of bins 5 to 8 seen from depth_camera_bins1,
+ * with parts at known poses, and runs them through DepthPipeline at
+ * several resolutions. Runs offline, no ROS master needed:
+ *   rosrun group5_rwa4 depth_pipeline_bench [frames]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <vector>
+#include "../../include/camera/depth_pipeline.h"
+
+namespace {
+    struct Box {
+        double x, y, yaw, length, width, height;
+    };
+
+    const double kBinBottom = 0.72;
+    const double kBinHalfSide = 0.3;
+    // bins 5 to 8, under depth_camera_bins1
+    const double kBins[4][2] = { { -1.898, -3.37 }, { -1.898, -2.56 }, { -2.651, -2.56 }, { -2.651, -3.37 } };
+    const double kFieldOfView = 1.05;
+    // depth_camera_bins1 from config/user_config/group5_config.yaml
+    const double kCameraX = -2.286283;
+
+    std::vector<Box> makeParts(std::mt19937& rng)
+    {
+        std::uniform_real_distribution<double> offset(-0.03, 0.03);
+        std::uniform_real_distribution<double> yaw(-M_PI / 2, M_PI / 2);
+        std::vector<Box> parts;
+        for (const auto& bin : kBins) {
+            // two parts per bin on the half closest to the camera, which sees
+            // only the inner halves of the bins, far enough apart not to touch
+            const double x = bin[0] + 0.4 * (kCameraX - bin[0]);
+            parts.push_back(Box{ x + offset(rng), bin[1] - 0.15, yaw(rng), 0.12, 0.06, 0.05 });
+            parts.push_back(Box{ x + offset(rng), bin[1] + 0.15, yaw(rng), 0.10, 0.05, 0.04 });
+        }
+        return parts;
+    }
+
+    // height of the first surface below (x, y)
+    double surface(const std::vector<Box>& parts, double x, double y)
+    {
+        for (const auto& part : parts) {
+            const double dx = x - part.x, dy = y - part.y;
+            const double u = dx * std::cos(part.yaw) + dy * std::sin(part.yaw);
+            const double v = dy * std::cos(part.yaw) - dx * std::sin(part.yaw);
+            if (std::abs(u) <= part.length / 2 && std::abs(v) <= part.width / 2)
+                return kBinBottom + part.height;
+        }
+        for (const auto& bin : kBins) {
+            if (std::abs(x - bin[0]) <= kBinHalfSide && std::abs(y - bin[1]) <= kBinHalfSide)
+                return kBinBottom;
+        }
+        return 0;
+    }
+
+    // one point per pixel of a downward camera, in the camera frame, 1% without a return
+    void render(const tf2::Transform& camera_in_world, const std::vector<Box>& parts, int width, int height,
+        std::mt19937& rng, std::vector<geometry_msgs::Point32>& cloud)
+    {
+        std::normal_distribution<double> noise(0, 0.001);
+        std::uniform_real_distribution<double> dropout(0, 1);
+        const double focal = width / 2 / std::tan(kFieldOfView / 2);
+        const tf2::Vector3& eye = camera_in_world.getOrigin();
+        cloud.resize(static_cast<std::size_t>(width) * height);
+        std::size_t p = 0;
+        for (int row = 0; row < height; row++) {
+            for (int col = 0; col < width; col++, p++) {
+                // camera looks along its x axis
+                const tf2::Vector3 ray(1.0, -(col - width / 2.0) / focal, -(row - height / 2.0) / focal);
+                const tf2::Vector3 dir = camera_in_world * ray - eye;
+                auto& point = cloud[p];
+                if (dropout(rng) < 0.01 || dir.z() >= 0) {
+                    point.x = point.y = point.z = std::numeric_limits<float>::quiet_NaN();
+                    continue;
+                }
+                // march down the ray in 1 mm steps to the first surface it crosses,
+                // the top of a part or its side
+                double t = (eye.z() - (kBinBottom + 0.1)) / -dir.z();
+                double z = 0;
+                for (int step = 0; step <= 100; step++) {
+                    const tf2::Vector3 at = eye + dir * t;
+                    z = surface(parts, at.x(), at.y());
+                    if (at.z() <= z)
+                        break;
+                    t += 0.001 / -dir.z();
+                }
+                // outside the bins, down to the floor
+                if (z < kBinBottom)
+                    t = (eye.z() - z) / -dir.z();
+                t += noise(rng);
+                point.x = static_cast<float>(ray.x() * t);
+                point.y = static_cast<float>(ray.y() * t);
+                point.z = static_cast<float>(ray.z() * t);
+            }
+        }
+    }
+
+    double since(const std::chrono::steady_clock::time_point& start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int frames = argc > 1 ? std::atoi(argv[1]) : 50;
+
+    tf2::Quaternion q;
+    q.setRPY(3.141593, 1.570792, 0.0);
+    const tf2::Transform camera_in_world(q, tf2::Vector3(kCameraX, -2.963994, 1.801095));
+
+    std::mt19937 rng(7);
+    const auto parts = makeParts(rng);
+    motioncontrol::PointBatch points, world_points;
+    motioncontrol::DepthPipeline pipeline;
+    std::vector<motioncontrol::DepthCluster> clusters;
+    std::vector<geometry_msgs::Point32> cloud;
+
+    std::printf("%10s %9s %9s %9s %9s %9s %9s %8s %7s %9s %9s\n", "cloud", "points", "copy ms", "voxel ms",
+        "plane ms", "clust ms", "total ms", "fps", "parts", "pos mm", "yaw deg");
+    const int sizes[][2] = { { 160, 120 }, { 320, 240 }, { 640, 480 }, { 1280, 960 } };
+    for (const auto& size : sizes) {
+        render(camera_in_world, parts, size[0], size[1], rng, cloud);
+
+        double copy_ms = 0, voxel_ms = 0, plane_ms = 0, cluster_ms = 0;
+        for (int frame = 0; frame < frames; frame++) {
+            auto start = std::chrono::steady_clock::now();
+            points.assign(cloud);
+            motioncontrol::transformPoints(camera_in_world, points, world_points);
+            copy_ms += since(start);
+            start = std::chrono::steady_clock::now();
+            pipeline.voxelize(world_points);
+            voxel_ms += since(start);
+            start = std::chrono::steady_clock::now();
+            pipeline.removePlane();
+            plane_ms += since(start);
+            start = std::chrono::steady_clock::now();
+            pipeline.cluster(clusters);
+            cluster_ms += since(start);
+        }
+
+        // every placed part against the closest part found
+        std::size_t found = 0;
+        double position_error = 0, yaw_error = 0;
+        for (const auto& part : parts) {
+            double best = std::numeric_limits<double>::max();
+            const motioncontrol::DepthCluster* match = nullptr;
+            for (const auto& cluster : clusters) {
+                const double d = std::hypot(cluster.centroid.x - part.x, cluster.centroid.y - part.y);
+                if (d < best) {
+                    best = d;
+                    match = &cluster;
+                }
+            }
+            if (!match || best > 0.05)
+                continue;
+            found++;
+            position_error = std::max(position_error, best);
+            // the principal axis has no direction, compare modulo pi
+            double dyaw = std::fmod(std::abs(match->yaw - part.yaw), M_PI);
+            yaw_error = std::max(yaw_error, std::min(dyaw, M_PI - dyaw));
+        }
+
+        const double total_ms = (copy_ms + voxel_ms + plane_ms + cluster_ms) / frames;
+        std::printf("%4dx%-5d %9zu %9.2f %9.2f %9.2f %9.2f %9.2f %8.1f %3zu/%-3zu %9.1f %9.1f\n", size[0], size[1],
+            cloud.size(), copy_ms / frames, voxel_ms / frames, plane_ms / frames, cluster_ms / frames, total_ms,
+            1000.0 / total_ms, found, parts.size(), position_error * 1000, yaw_error * 180 / M_PI);
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file sensor_replay.cpp
+ * @brief Replays a sensor log through the perception and order callbacks
+ *
+ * Record a run by starting My_node with _record:=/path/to/run.g5log, then
+ * replay it offline, no ROS master needed:
+ *   rosrun group5_rwa4 sensor_replay /path/to/run.g5log [speed]
+ * speed is a multiple of the recorded rate, 0 (the default) replays as
+ * fast as the callbacks go.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "../../include/comp/comp_class.h"
+#include "../../include/camera/logical_camera.h"
+#include "../../include/camera/inventory.h"
+#include "../../include/util/sensor_log.h"
+
+namespace {
+    // registrations with an absent master give up after this instead of waiting for one
+    const double kMasterRetry = 0.05;
+
+    const char* const kKindNames[motioncontrol::kRecordKindCount] = {
+        "transform", "logical camera", "breakbeam", "laser scan", "order", "gripper state"
+    };
+}
+
+int main(int argc, char** argv)
+{
+    ros::init(argc, argv, "sensor_replay",
+        ros::init_options::NoSigintHandler | ros::init_options::NoRosout | ros::init_options::AnonymousName);
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: sensor_replay <log> [speed]\n");
+        return 1;
+    }
+    const double speed = argc > 2 ? std::atof(argv[2]) : 0.0;
+
+    motioncontrol::SensorLog log;
+    if (!log.open(argv[1])) {
+        std::fprintf(stderr, "cannot read %s\n", argv[1]);
+        return 1;
+    }
+    if (log.records().empty()) {
+        std::fprintf(stderr, "%s holds no records\n", argv[1]);
+        return 1;
+    }
+
+    // start the clock at the recording, nothing below may wait on a master
+    ros::Time::setNow(log.records().front().stamp);
+    if (!ros::master::check())
+        ros::master::setRetryTimeout(ros::WallDuration(kMasterRetry));
+    ros::NodeHandle node;
+    MyCompetitionClass comp_class(node);
+    LogicalCamera cam(node);
+
+    std::size_t attached[2] = { 0, 0 };
+    bool was_attached[2] = { false, false };
+    motioncontrol::SensorReplayer::Handlers handlers;
+    handlers.logical_camera = [&cam](motioncontrol::SensorId sensor, const nist_gear::LogicalCameraImage::ConstPtr& msg) {
+        cam.ingest(sensor, msg);
+    };
+    handlers.breakbeam = [&comp_class](const nist_gear::Proximity::ConstPtr& msg) { comp_class.breakbeam0_callback(msg); };
+    handlers.laser_scan = [&comp_class](const sensor_msgs::LaserScan::ConstPtr& msg) { comp_class.laser_profiler0_callback(msg); };
+    handlers.order = [&comp_class](const nist_gear::Order::ConstPtr& msg) { comp_class.order_callback(msg); };
+    // the arms need move_group, only count the grasps
+    handlers.gripper_state = [&](std::uint16_t arm, const nist_gear::VacuumGripperState::ConstPtr& msg) {
+        if (arm < 2 && msg->attached && !was_attached[arm])
+            attached[arm]++;
+        if (arm < 2)
+            was_attached[arm] = msg->attached;
+    };
+
+    const auto stats = motioncontrol::SensorReplayer::replay(log, speed, handlers);
+
+    std::size_t total = 0;
+    std::printf("%-16s %10s\n", "record", "count");
+    for (std::size_t kind = 0; kind < motioncontrol::kRecordKindCount; kind++) {
+        std::printf("%-16s %10zu\n", kKindNames[kind], stats.records[kind]);
+        total += stats.records[kind];
+    }
+    std::printf("%zu records, %.1f s of recording replayed in %.3f s (%.1fx)\n", total, stats.log_seconds,
+        stats.wall_seconds, stats.wall_seconds > 0 ? stats.log_seconds / stats.wall_seconds : 0.0);
+    std::printf("grasps: kitting arm %zu, gantry %zu\n", attached[0], attached[1]);
+
+    // what the callbacks made of it
+    std::printf("\n%-28s %10s %10s %8s\n", "camera", "processed", "skipped", "parts");
+    const auto world = cam.snapshot();
+    for (std::size_t i = 0; i < motioncontrol::kLogicalCameraCount; i++) {
+        const auto sensor = motioncontrol::cameraAt(i);
+        const auto frames = cam.get_frame_counters(sensor);
+        if (frames.processed + frames.skipped == 0)
+            continue;
+        std::printf("%-28s %10llu %10llu %8zu\n", motioncontrol::sensorInfo(sensor).name,
+            static_cast<unsigned long long>(frames.processed), static_cast<unsigned long long>(frames.skipped),
+            world->value.parts[i]->size());
+    }
+    const auto orders = comp_class.get_orders();
+    std::printf("\n%zu order(s)\n", orders->value.size());
+    for (const auto& order : orders->value) {
+        for (const auto& shipment : motioncontrol::Inventory::instance().check(*order))
+            std::printf("  %-24s %s\n", shipment.shipment_type.c_str(), shipment.feasible() ? "feasible" : "short of parts");
+    }
+    return 0;
+}
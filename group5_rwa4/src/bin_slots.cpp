@@ -0,0 +1,213 @@
+#include "../include/camera/bin_slots.h"
+#include <cmath>
+#include <limits>
+#include <string>
+#include <utility>
+
+namespace motioncontrol {
+
+    namespace {
+        // centers of bins 1 to 8, at the height parts are placed
+        const std::array<std::array<double, 3>, BinSlots::kBinCount> kBinCenters{ {
+            { -1.898, 3.37, 0.751 },
+            { -1.898, 2.56, 0.751 },
+            { -2.651, 2.56, 0.751 },
+            { -2.651, 3.37, 0.751 },
+            { -1.898, -3.37, 0.751 },
+            { -1.898, -2.56, 0.751 },
+            { -2.651, -2.56, 0.751 },
+            { -2.651, -3.37, 0.751 },
+        } };
+
+        // footprint radius by the family in the type name, in meters
+        const std::array<std::pair<const char*, double>, 4> kFootprints{ {
+            { "pump", 0.10 },
+            { "battery", 0.09 },
+            { "sensor", 0.08 },
+            { "regulator", 0.07 },
+        } };
+        const double kLargestFootprint = 0.10;
+
+        double squaredDistance(const geometry_msgs::Point& a, const geometry_msgs::Point& b)
+        {
+            const double dx = a.x - b.x;
+            const double dy = a.y - b.y;
+            return dx * dx + dy * dy;
+        }
+    }  // namespace
+
+    constexpr int BinSlots::kBinCount;
+    constexpr double BinSlots::kCellSize;
+    constexpr double BinSlots::kBinHalfSide;
+    constexpr double BinSlots::kClearance;
+    constexpr double BinSlots::kReservationTime;
+    constexpr int BinSlots::kCells;
+
+    BinSlots& BinSlots::instance()
+    {
+        static BinSlots slots;
+        return slots;
+    }
+
+    double BinSlots::footprint(PartType type)
+    {
+        for (const auto& family : kFootprints) {
+            if (type.name().find(family.first) != std::string::npos)
+                return family.second;
+        }
+        return kLargestFootprint;
+    }
+
+    bool BinSlots::valid(int bin)
+    {
+        return bin >= 1 && bin <= kBinCount;
+    }
+
+    geometry_msgs::Point BinSlots::center(int bin)
+    {
+        geometry_msgs::Point point;
+        if (!valid(bin))
+            return point;
+        const auto& c = kBinCenters[bin - 1];
+        point.x = c[0];
+        point.y = c[1];
+        point.z = c[2];
+        return point;
+    }
+
+    void BinSlots::rasterize(Bin& bin, const geometry_msgs::Point& center)
+    {
+        bin.cells.fill(0);
+        auto mark = [&](const Disc& disc) {
+            for (int cx = 0; cx < kCells; cx++) {
+                for (int cy = 0; cy < kCells; cy++) {
+                    geometry_msgs::Point cell;
+                    cell.x = center.x - kBinHalfSide + (cx + 0.5) * kCellSize;
+                    cell.y = center.y - kBinHalfSide + (cy + 0.5) * kCellSize;
+                    if (squaredDistance(cell, disc.at) <= disc.radius * disc.radius)
+                        bin.cells[cx * kCells + cy] = 1;
+                }
+            }
+        };
+        for (const auto& disc : bin.parts)
+            mark(disc);
+        for (const auto& disc : bin.reserved)
+            mark(disc);
+    }
+
+    void BinSlots::update(std::size_t first_bin, const std::array<std::vector<Product>,4>& bins)
+    {
+        const ros::Time now = ros::Time::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (std::size_t i = 0; i < bins.size() && first_bin + i < bins_.size(); i++) {
+            auto& bin = bins_[first_bin + i];
+            bin.parts.clear();
+            for (const auto& part : bins[i])
+                bin.parts.push_back(Disc{ part.world_pose.position, footprint(part.type), now });
+
+            // a reservation ends when a part is seen on it, or when it gets too old
+            for (auto disc = bin.reserved.begin(); disc != bin.reserved.end();) {
+                bool seen = false;
+                for (const auto& part : bin.parts)
+                    seen = seen || squaredDistance(part.at, disc->at) <= part.radius * part.radius;
+                if (seen || (now - disc->stamp).toSec() > kReservationTime)
+                    disc = bin.reserved.erase(disc);
+                else
+                    ++disc;
+            }
+            rasterize(bin, center(static_cast<int>(first_bin + i) + 1));
+        }
+    }
+
+    bool BinSlots::fitsLocked(int bin, const geometry_msgs::Point& at, double radius) const
+    {
+        const auto c = center(bin);
+        if (std::abs(at.x - c.x) + radius > kBinHalfSide || std::abs(at.y - c.y) + radius > kBinHalfSide)
+            return false;
+        const double reach = radius + kClearance;
+        const auto& cells = bins_[bin - 1].cells;
+        for (int cx = 0; cx < kCells; cx++) {
+            for (int cy = 0; cy < kCells; cy++) {
+                if (!cells[cx * kCells + cy])
+                    continue;
+                geometry_msgs::Point cell;
+                cell.x = c.x - kBinHalfSide + (cx + 0.5) * kCellSize;
+                cell.y = c.y - kBinHalfSide + (cy + 0.5) * kCellSize;
+                if (squaredDistance(cell, at) <= reach * reach)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    bool BinSlots::fits(int bin, const geometry_msgs::Point& at, PartType type) const
+    {
+        if (!valid(bin))
+            return false;
+        std::lock_guard<std::mutex> lock(mutex_);
+        return fitsLocked(bin, at, footprint(type));
+    }
+
+    void BinSlots::reserveLocked(int bin, const geometry_msgs::Point& at, double radius)
+    {
+        auto& slots = bins_[bin - 1];
+        slots.reserved.push_back(Disc{ at, radius, ros::Time::now() });
+        rasterize(slots, center(bin));
+    }
+
+    bool BinSlots::reserve(int bin, const geometry_msgs::Point& at, PartType type)
+    {
+        if (!valid(bin))
+            return false;
+        std::lock_guard<std::mutex> lock(mutex_);
+        const double radius = footprint(type);
+        if (!fitsLocked(bin, at, radius))
+            return false;
+        reserveLocked(bin, at, radius);
+        return true;
+    }
+
+    bool BinSlots::allocate(PartType type, const geometry_msgs::Point& robot, const std::vector<int>& bins,
+        int& bin, geometry_msgs::Pose& slot)
+    {
+        const double radius = footprint(type);
+        std::lock_guard<std::mutex> lock(mutex_);
+        double best = std::numeric_limits<double>::max();
+        for (int candidate : bins) {
+            if (!valid(candidate))
+                continue;
+            const auto c = center(candidate);
+            for (int cx = 0; cx < kCells; cx++) {
+                for (int cy = 0; cy < kCells; cy++) {
+                    geometry_msgs::Point at;
+                    at.x = c.x - kBinHalfSide + (cx + 0.5) * kCellSize;
+                    at.y = c.y - kBinHalfSide + (cy + 0.5) * kCellSize;
+                    at.z = c.z;
+                    const double distance = squaredDistance(at, robot);
+                    if (distance < best && fitsLocked(candidate, at, radius)) {
+                        best = distance;
+                        bin = candidate;
+                        slot = geometry_msgs::Pose();
+                        slot.position = at;
+                        slot.orientation.w = 1;
+                    }
+                }
+            }
+        }
+        if (best == std::numeric_limits<double>::max())
+            return false;
+        reserveLocked(bin, slot.position, radius);
+        return true;
+    }
+
+    std::size_t BinSlots::freeCells(int bin) const
+    {
+        if (!valid(bin))
+            return 0;
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::size_t count = 0;
+        for (auto cell : bins_[bin - 1].cells)
+            count += cell ? 0 : 1;
+        return count;
+    }
+}  // namespace motioncontrol
@@ -0,0 +1,67 @@
+#include "../include/camera/depth_localizer.h"
+#include "../include/util/transform_service.h"
+#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+
+namespace motioncontrol {
+
+    namespace {
+        const ros::Duration kCameraLookupTimeout(0.5);
+    }  // namespace
+
+    DepthLocalizer& DepthLocalizer::instance()
+    {
+        static DepthLocalizer localizer;
+        return localizer;
+    }
+
+    void DepthLocalizer::process(const sensor_msgs::PointCloud& cloud)
+    {
+        tf2::Transform camera_in_world;
+        if (!frameInWorld(cloud.header.frame_id, camera_in_world))
+            return;
+
+        // a cloud arriving while the previous one is processed is dropped
+        std::unique_lock<std::mutex> busy(process_mutex_, std::try_to_lock);
+        if (!busy.owns_lock())
+            return;
+        points_.assign(cloud.points);
+        transformPoints(camera_in_world, points_, world_points_);
+        pipeline_.process(world_points_, found_);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        parts_.swap(found_);
+        stamp_ = cloud.header.stamp;
+        received_ = true;
+    }
+
+    bool DepthLocalizer::latest(std::vector<DepthCluster>& parts, ros::Time& stamp) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!received_)
+            return false;
+        parts = parts_;
+        stamp = stamp_;
+        return true;
+    }
+
+    bool DepthLocalizer::frameInWorld(const std::string& frame, tf2::Transform& frame_in_world)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto known = frames_.find(frame);
+            if (known != frames_.end()) {
+                frame_in_world = known->second;
+                return true;
+            }
+        }
+        geometry_msgs::TransformStamped world_camera_tf;
+        if (!TransformService::instance().waitForTransform("world", frame, ros::Time::now() + kCameraLookupTimeout, world_camera_tf)) {
+            ROS_WARN_STREAM("[DepthLocalizer] no pose for depth camera " << frame);
+            return false;
+        }
+        tf2::fromMsg(world_camera_tf.transform, frame_in_world);
+        std::lock_guard<std::mutex> lock(mutex_);
+        frames_[frame] = frame_in_world;
+        return true;
+    }
+}  // namespace motioncontrol
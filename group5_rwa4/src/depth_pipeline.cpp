@@ -0,0 +1,303 @@
+#include "../include/camera/depth_pipeline.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace motioncontrol {
+
+    namespace {
+        // bits of the radix sort digits
+        const unsigned kDigitBits = 8;
+
+        unsigned bitsFor(std::uint64_t cells)
+        {
+            unsigned bits = 1;
+            while (bits < 63 && (std::uint64_t{1} << bits) < cells)
+                bits++;
+            return bits;
+        }
+    }  // namespace
+
+    constexpr float DepthPipeline::kVoxelSize;
+    constexpr float DepthPipeline::kPlaneBinSize;
+    constexpr float DepthPipeline::kPlaneShare;
+    constexpr float DepthPipeline::kPlaneTolerance;
+    constexpr float DepthPipeline::kTopBand;
+    constexpr std::size_t DepthPipeline::kMinVoxels;
+    constexpr double DepthPipeline::kMaxLength;
+
+    void DepthPipeline::process(const PointBatch& points, std::vector<DepthCluster>& clusters)
+    {
+        voxelize(points);
+        removePlane();
+        cluster(clusters);
+    }
+
+    std::size_t DepthPipeline::voxelize(const PointBatch& points)
+    {
+        const std::size_t n = points.size();
+        const float* px = points.x.data();
+        const float* py = points.y.data();
+        const float* pz = points.z.data();
+        keys_.clear();
+        voxels_.resize(0);
+
+        // bounds of the points with a return
+        const float inf = std::numeric_limits<float>::infinity();
+        float min_x = inf, min_y = inf, min_z = inf;
+        float max_x = -inf, max_y = -inf, max_z = -inf;
+        for (std::size_t i = 0; i < n; i++) {
+            if (!std::isfinite(px[i]) || !std::isfinite(py[i]) || !std::isfinite(pz[i]))
+                continue;
+            min_x = std::min(min_x, px[i]);
+            min_y = std::min(min_y, py[i]);
+            min_z = std::min(min_z, pz[i]);
+            max_x = std::max(max_x, px[i]);
+            max_y = std::max(max_y, py[i]);
+            max_z = std::max(max_z, pz[i]);
+        }
+        if (min_x > max_x)
+            return 0;
+
+        // one empty cell on each side, so the neighbours of a voxel never wrap
+        const float inv = 1.0f / kVoxelSize;
+        const float origin_x = min_x - kVoxelSize;
+        const float origin_y = min_y - kVoxelSize;
+        const float origin_z = min_z - kVoxelSize;
+        const unsigned z_bits = bitsFor(static_cast<std::uint64_t>((max_z - origin_z) * inv) + 2);
+        const unsigned y_bits = bitsFor(static_cast<std::uint64_t>((max_y - origin_y) * inv) + 2);
+        const unsigned x_bits = bitsFor(static_cast<std::uint64_t>((max_x - origin_x) * inv) + 2);
+        // a key must stay below 2^63 for the neighbour offsets
+        if (x_bits + y_bits + z_bits > 63)
+            return 0;
+        y_shift_ = z_bits;
+        x_shift_ = y_bits + z_bits;
+        key_bits_ = x_bits + y_bits + z_bits;
+
+        keyed_.resize(n);
+        std::size_t valid = 0;
+        for (std::size_t i = 0; i < n; i++) {
+            if (!std::isfinite(px[i]) || !std::isfinite(py[i]) || !std::isfinite(pz[i]))
+                continue;
+            const auto cx = static_cast<std::uint64_t>((px[i] - origin_x) * inv);
+            const auto cy = static_cast<std::uint64_t>((py[i] - origin_y) * inv);
+            const auto cz = static_cast<std::uint64_t>((pz[i] - origin_z) * inv);
+            keyed_[valid++] = Keyed{ (cx << x_shift_) | (cy << y_shift_) | cz, static_cast<std::uint32_t>(i) };
+        }
+        keyed_.resize(valid);
+
+        // LSD radix sort on the bits the keys use, stable so each voxel keeps its points together
+        sorted_.resize(valid);
+        std::array<std::uint32_t, 1u << kDigitBits> offsets;
+        for (unsigned shift = 0; shift < key_bits_; shift += kDigitBits) {
+            offsets.fill(0);
+            for (const auto& k : keyed_)
+                offsets[(k.key >> shift) & ((1u << kDigitBits) - 1)]++;
+            std::uint32_t sum = 0;
+            for (auto& offset : offsets) {
+                const std::uint32_t count = offset;
+                offset = sum;
+                sum += count;
+            }
+            for (const auto& k : keyed_)
+                sorted_[offsets[(k.key >> shift) & ((1u << kDigitBits) - 1)]++] = k;
+            keyed_.swap(sorted_);
+        }
+
+        // average each run of equal keys
+        voxels_.resize(valid);
+        std::size_t count = 0;
+        for (std::size_t begin = 0; begin < valid;) {
+            const std::uint64_t key = keyed_[begin].key;
+            double sx = 0, sy = 0, sz = 0;
+            std::size_t end = begin;
+            for (; end < valid && keyed_[end].key == key; end++) {
+                const auto i = keyed_[end].index;
+                sx += px[i];
+                sy += py[i];
+                sz += pz[i];
+            }
+            const double points_in_voxel = static_cast<double>(end - begin);
+            voxels_.x[count] = static_cast<float>(sx / points_in_voxel);
+            voxels_.y[count] = static_cast<float>(sy / points_in_voxel);
+            voxels_.z[count] = static_cast<float>(sz / points_in_voxel);
+            keys_.push_back(key);
+            count++;
+            begin = end;
+        }
+        voxels_.resize(count);
+        return count;
+    }
+
+    std::size_t DepthPipeline::removePlane()
+    {
+        const std::size_t n = voxels_.size();
+        if (n == 0)
+            return 0;
+        const float* vz = voxels_.z.data();
+
+        const auto bounds = std::minmax_element(vz, vz + n);
+        const float low = *bounds.first;
+        const std::size_t bins = static_cast<std::size_t>((*bounds.second - low) / kPlaneBinSize) + 1;
+        histogram_.assign(bins, 0);
+        for (std::size_t i = 0; i < n; i++)
+            histogram_[static_cast<std::size_t>((vz[i] - low) / kPlaneBinSize)]++;
+
+        // the plane is the highest height nearly as populated as the most
+        // populated one, so the bin bottoms win over the floor around the
+        // bins, refined with the voxels around it
+        const std::uint32_t peak = *std::max_element(histogram_.begin(), histogram_.end());
+        std::size_t mode = bins - 1;
+        while (histogram_[mode] < kPlaneShare * peak)
+            mode--;
+        const float band_low = low + (static_cast<float>(mode) - 1) * kPlaneBinSize;
+        const float band_high = low + (static_cast<float>(mode) + 2) * kPlaneBinSize;
+        double sum = 0;
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < n; i++) {
+            if (vz[i] >= band_low && vz[i] < band_high) {
+                sum += vz[i];
+                count++;
+            }
+        }
+        plane_z_ = static_cast<float>(sum / count);
+
+        // keep the voxels above the plane, in key order
+        const float cut = plane_z_ + kPlaneTolerance;
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < n; i++) {
+            if (vz[i] <= cut)
+                continue;
+            keys_[kept] = keys_[i];
+            voxels_.x[kept] = voxels_.x[i];
+            voxels_.y[kept] = voxels_.y[i];
+            voxels_.z[kept] = voxels_.z[i];
+            kept++;
+        }
+        keys_.resize(kept);
+        voxels_.resize(kept);
+        return kept;
+    }
+
+    std::uint32_t DepthPipeline::root(std::uint32_t i)
+    {
+        while (parent_[i] != i) {
+            parent_[i] = parent_[parent_[i]];
+            i = parent_[i];
+        }
+        return i;
+    }
+
+    void DepthPipeline::cluster(std::vector<DepthCluster>& clusters)
+    {
+        clusters.clear();
+        const std::size_t n = keys_.size();
+        if (n == 0)
+            return;
+
+        // half of the 26 neighbours, those with a larger key, the other half finds this voxel
+        const std::int64_t step_x = std::int64_t{1} << x_shift_;
+        const std::int64_t step_y = std::int64_t{1} << y_shift_;
+        std::array<std::int64_t, 13> forward;
+        std::size_t f = 0;
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dz = -1; dz <= 1; dz++) {
+                    const std::int64_t delta = dx * step_x + dy * step_y + dz;
+                    if (delta > 0)
+                        forward[f++] = delta;
+                }
+            }
+        }
+
+        parent_.resize(n);
+        for (std::uint32_t i = 0; i < n; i++)
+            parent_[i] = i;
+        for (std::size_t i = 0; i < n; i++) {
+            for (auto delta : forward) {
+                const std::uint64_t neighbour = keys_[i] + static_cast<std::uint64_t>(delta);
+                auto found = std::lower_bound(keys_.begin() + i + 1, keys_.end(), neighbour);
+                if (found == keys_.end() || *found != neighbour)
+                    continue;
+                const std::uint32_t a = root(static_cast<std::uint32_t>(i));
+                const std::uint32_t b = root(static_cast<std::uint32_t>(found - keys_.begin()));
+                if (a != b)
+                    parent_[std::max(a, b)] = std::min(a, b);
+            }
+        }
+
+        // size and top of each group
+        const float* vx = voxels_.x.data();
+        const float* vy = voxels_.y.data();
+        const float* vz = voxels_.z.data();
+        stats_.assign(n, Stats{});
+        for (std::uint32_t i = 0; i < n; i++) {
+            const std::uint32_t r = root(i);
+            parent_[i] = r;
+            auto& s = stats_[r];
+            s.top = s.count == 0 ? vz[i] : std::max(s.top, vz[i]);
+            s.count++;
+        }
+
+        // moments of the top face, the camera sees the sides of the parts
+        // on one side only and they would pull the estimates toward it
+        for (std::uint32_t i = 0; i < n; i++) {
+            auto& s = stats_[parent_[i]];
+            if (s.count < kMinVoxels || vz[i] < s.top - kTopBand)
+                continue;
+            s.face++;
+            s.sx += vx[i];
+            s.sy += vy[i];
+            s.sz += vz[i];
+            s.sxx += static_cast<double>(vx[i]) * vx[i];
+            s.syy += static_cast<double>(vy[i]) * vy[i];
+            s.sxy += static_cast<double>(vx[i]) * vy[i];
+        }
+
+        // principal axis of the top face, then its extents along and across it
+        for (std::uint32_t i = 0; i < n; i++) {
+            auto& s = stats_[i];
+            if (parent_[i] != i || s.count < kMinVoxels)
+                continue;
+            const double mx = s.sx / s.face, my = s.sy / s.face;
+            const double cxx = s.sxx / s.face - mx * mx;
+            const double cyy = s.syy / s.face - my * my;
+            const double cxy = s.sxy / s.face - mx * my;
+            s.yaw = 0.5 * std::atan2(2 * cxy, cxx - cyy);
+            s.ux = std::cos(s.yaw);
+            s.uy = std::sin(s.yaw);
+            s.lo_u = s.lo_v = std::numeric_limits<double>::max();
+            s.hi_u = s.hi_v = std::numeric_limits<double>::lowest();
+        }
+        for (std::uint32_t i = 0; i < n; i++) {
+            auto& s = stats_[parent_[i]];
+            if (s.count < kMinVoxels || vz[i] < s.top - kTopBand)
+                continue;
+            const double u = vx[i] * s.ux + vy[i] * s.uy;
+            const double v = vy[i] * s.ux - vx[i] * s.uy;
+            s.lo_u = std::min(s.lo_u, u);
+            s.hi_u = std::max(s.hi_u, u);
+            s.lo_v = std::min(s.lo_v, v);
+            s.hi_v = std::max(s.hi_v, v);
+        }
+
+        for (std::uint32_t i = 0; i < n; i++) {
+            const auto& s = stats_[i];
+            if (parent_[i] != i || s.count < kMinVoxels)
+                continue;
+            DepthCluster part;
+            part.length = s.hi_u - s.lo_u + kVoxelSize;
+            if (part.length > kMaxLength)
+                continue;
+            part.width = s.hi_v - s.lo_v + kVoxelSize;
+            part.centroid.x = s.sx / s.face;
+            part.centroid.y = s.sy / s.face;
+            part.centroid.z = s.sz / s.face;
+            part.yaw = s.yaw;
+            part.height = s.top - plane_z_;
+            part.voxels = s.count;
+            clusters.push_back(part);
+        }
+    }
+}  // namespace motioncontrol
@@ -0,0 +1,200 @@
+#include "../include/camera/inventory.h"
+#include <limits>
+
+namespace {
+    // squared distance between two points
+    double squaredDistance(const geometry_msgs::Point& a, const geometry_msgs::Point& b)
+    {
+        const double dx = a.x - b.x;
+        const double dy = a.y - b.y;
+        const double dz = a.z - b.z;
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    // assembly station of a camera over an AGV there (e.g., "as2" for logical_camera_agv1as2), empty otherwise
+    std::string stationOf(motioncontrol::SensorId camera)
+    {
+        const std::string name = motioncontrol::sensorInfo(camera).name;
+        if (name.size() < 3 || name.compare(name.size() - 3, 2, "as") != 0)
+            return std::string();
+        return name.substr(name.size() - 3);
+    }
+}  // namespace
+
+namespace motioncontrol {
+
+    Inventory& Inventory::instance()
+    {
+        static Inventory inventory;
+        return inventory;
+    }
+
+    void Inventory::update(SensorId camera, const std::vector<Product>& parts)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& seen = seen_.at(index(camera));
+        for (const auto& previous : seen) {
+            auto& free = types_[previous.first].free;
+            auto instance = free.find(previous.second);
+            if (instance != free.end() && --instance->second.cameras == 0)
+                free.erase(instance);
+        }
+        seen.clear();
+        for (const auto& part : parts) {
+            if (part.id == 0 || reserved_.count(part.id) || consumed_.count(part.id))
+                continue;
+            auto& instance = types_[part.type].free[part.id];
+            instance.part = part;
+            instance.cameras++;
+            seen.emplace_back(part.type, part.id);
+        }
+    }
+
+    void Inventory::apply(const std::vector<PartEvent>& events)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& event : events) {
+            auto entry = types_.find(event.part.type);
+            if (entry == types_.end())
+                continue;
+            auto instance = entry->second.free.find(event.part.id);
+            if (instance == entry->second.free.end())
+                continue;
+            switch (event.type) {
+                case PartEvent::Type::kDisappeared:
+                    entry->second.free.erase(instance);
+                    break;
+                case PartEvent::Type::kMoved:
+                    instance->second.part = event.part;
+                    break;
+                case PartEvent::Type::kAppeared:
+                    // added by update() with the camera that sees it
+                    break;
+            }
+        }
+    }
+
+    Inventory::Counts Inventory::counts(PartType type) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto entry = types_.find(type);
+        if (entry == types_.end())
+            return Counts{ 0, 0, 0 };
+        return Counts{ entry->second.free.size(), entry->second.reserved, entry->second.consumed };
+    }
+
+    std::vector<Product> Inventory::freeParts(PartType type) const
+    {
+        std::vector<Product> parts;
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto entry = types_.find(type);
+        if (entry == types_.end())
+            return parts;
+        parts.reserve(entry->second.free.size());
+        for (const auto& instance : entry->second.free)
+            parts.push_back(instance.second.part);
+        return parts;
+    }
+
+    bool Inventory::reserve(const Product& part)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& entry = types_[part.type];
+        if (!entry.free.erase(part.id))
+            return false;
+        reserved_.insert(part.id);
+        entry.reserved++;
+        return true;
+    }
+
+    void Inventory::consume(const Product& part)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& entry = types_[part.type];
+        if (part.id == 0) {
+            // untracked part: use up the closest free part of its type
+            auto closest = entry.free.end();
+            double best = std::numeric_limits<double>::max();
+            for (auto instance = entry.free.begin(); instance != entry.free.end(); ++instance) {
+                const double distance = squaredDistance(instance->second.part.world_pose.position, part.world_pose.position);
+                if (distance < best) {
+                    best = distance;
+                    closest = instance;
+                }
+            }
+            if (closest != entry.free.end()) {
+                consumed_.insert(closest->first);
+                entry.free.erase(closest);
+            }
+            entry.consumed++;
+            return;
+        }
+        if (!consumed_.insert(part.id).second)
+            return;
+        if (reserved_.erase(part.id))
+            entry.reserved--;
+        else
+            entry.free.erase(part.id);
+        entry.consumed++;
+    }
+
+    void Inventory::stock(Stock& bins, std::map<std::string, Stock>& stations) const
+    {
+        std::unordered_set<std::uint32_t> counted;
+        for (std::size_t i = 0; i < kLogicalCameraCount; i++) {
+            const std::string station = stationOf(cameraAt(i));
+            for (const auto& part : seen_[i]) {
+                auto entry = types_.find(part.first);
+                if (entry == types_.end() || !entry->second.free.count(part.second) || !counted.insert(part.second).second)
+                    continue;
+                (station.empty() ? bins : stations[station])[part.first]++;
+            }
+        }
+    }
+
+    Inventory::ShipmentCheck Inventory::check(const std::vector<Product>& products, Stock& remaining) const
+    {
+        ShipmentCheck result;
+        for (const auto& product : products) {
+            auto& available = remaining[product.type];
+            if (available > 0)
+                available--;
+            else
+                result.missing[product.type]++;
+        }
+        return result;
+    }
+
+    Inventory::ShipmentCheck Inventory::check(const std::vector<Product>& products) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Stock bins;
+        std::map<std::string, Stock> stations;
+        stock(bins, stations);
+        return check(products, bins);
+    }
+
+    std::vector<Inventory::ShipmentCheck> Inventory::check(const Order& order) const
+    {
+        std::vector<ShipmentCheck> checks;
+        std::lock_guard<std::mutex> lock(mutex_);
+        Stock bins;
+        std::map<std::string, Stock> stations;
+        stock(bins, stations);
+        for (const auto& kit : order.kitting) {
+            checks.push_back(check(kit.products, bins));
+            checks.back().shipment_type = kit.shipment_type;
+            // the parts of the kit that can be supplied arrive at its station
+            auto& delivered = stations[kit.station_id];
+            for (const auto& product : kit.products)
+                delivered[product.type]++;
+            for (const auto& missing : checks.back().missing)
+                delivered[missing.first] -= missing.second;
+        }
+        for (const auto& asmb : order.assembly) {
+            checks.push_back(check(asmb.products, stations[asmb.stations]));
+            checks.back().shipment_type = asmb.shipment_type;
+        }
+        return checks;
+    }
+}  // namespace motioncontrol
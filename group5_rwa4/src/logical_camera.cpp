@@ -1,10 +1,65 @@
 #include "../include/camera/logical_camera.h"
+#include "../include/util/workcell_transforms.h"
+#include "../include/util/sensor_health.h"
+#include "../include/util/sim_clock.h"
+#include "../include/camera/belt_tracker.h"
+#include "../include/camera/inventory.h"
+#include "../include/camera/bin_slots.h"
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace {
+  // Bins are laid out in two rows on each side of the workcell, around these lines.
+  const double kBinRowX = -2.28;
+  const double kBinColumnY = 2.96;
+  /// A faulty part farther than this from a placement belongs to another part of the kit
+  const double kFaultMatchRadius = 0.2;
+
+  /**
+   * @brief Bin holding a part seen by a bin camera
+   *
+   * @return int Bin number, 0 when the part is on a boundary
+   */
+  int bin_of(const motioncontrol::SensorInfo& sensor, const geometry_msgs::Pose& world_pose){
+    const double x = world_pose.position.x;
+    const double y = sensor.bin_side * world_pose.position.y;
+    if (x == kBinRowX || y == kBinColumnY)
+      return 0;
+    if (x > kBinRowX)
+      return sensor.first_bin + (y > kBinColumnY ? 0 : 1);
+    return sensor.first_bin + (y > kBinColumnY ? 3 : 2);
+  }
+
+  // Resolution of the frame signature: 1 mm and 0.001 on the quaternion.
+  const double kSignatureScale = 1000.0;
+
+  /**
+   * @brief Quantized content of an image: per model the type and the pose in the camera frame
+   */
+  void frame_signature(const nist_gear::LogicalCameraImage& image, std::vector<std::int64_t>& signature){
+    signature.clear();
+    signature.reserve(image.models.size() * 8);
+    for (const auto& model: image.models){
+      const auto& pose = model.pose;
+      signature.push_back(static_cast<std::int64_t>(std::hash<std::string>()(model.type)));
+      for (double v: {pose.position.x, pose.position.y, pose.position.z,
+                      pose.orientation.x, pose.orientation.y, pose.orientation.z, pose.orientation.w})
+        signature.push_back(std::llround(v * kSignatureScale));
+    }
+  }
+}
 
 LogicalCamera::LogicalCamera(ros::NodeHandle & node) 
-: tfBuffer(), tfListener(tfBuffer)
+: tfBuffer(motioncontrol::TransformService::instance().buffer())
 {
     node_ = node;
-
+    world_.update([](WorldModel& world){
+      const auto empty = std::make_shared<const std::vector<Product> >();
+      world.parts.fill(empty);
+      world.bins.fill(empty);
+      world.faulty_parts.fill(empty);
+    });
 }
 
 void LogicalCamera::callback(const ros::TimerEvent& event){
@@ -16,673 +71,286 @@ bool LogicalCamera::get_timer(){
 }
 
 
-void LogicalCamera::logical_camera_bins0_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-     blackout_time_ = ros::Time::now().toSec(); 
-     if (get_cam[0])
-     { 
-      ros::Duration timeout(5.0);
-      unsigned short int i{0};
-      while(i < image_msg->models.size())
-      {
-        std::string product_type = image_msg->models.at(i).type;
-        Product product;
-        product.type = product_type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_bins0";
-        product.status = "free";
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        if(world_pose.position.x > -2.28 && world_pose.position.y > 2.96){
-          product.bin_number = 1;
-          bins_list.at(0).push_back(product);
-        }
-        else if( world_pose.position.x > -2.28 && world_pose.position.y < 2.96){
-          product.bin_number = 2;
-          bins_list.at(1).push_back(product);
-        }
-        else if(world_pose.position.x < -2.28 && world_pose.position.y < 2.96){
-          product.bin_number = 3;
-          bins_list.at(2).push_back(product);
-        }
-        else if(world_pose.position.x < -2.28 && world_pose.position.y > 2.96){
-          product.bin_number = 4;
-          bins_list.at(3).push_back(product);
-        }
-        camera_parts_list.at(0).push_back(product);
-        i++; 
-      }
-     get_cam[0] = false; 
-     }
-}
-
-
-void LogicalCamera::logical_camera_bins1_callback(
-  const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-    blackout_time_ = ros::Time::now().toSec();
-    if (get_cam[1])
-     { 
-      ros::Duration timeout(5.0);
-      unsigned short int i{0}; 
-      while(i < image_msg->models.size()){
-        Product product;
-        product.type = image_msg->models.at(i).type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_bins1";
-        product.status = "free"; 
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        if(world_pose.position.x > -2.28 && world_pose.position.y < -2.96){
-          product.bin_number = 5;
-          bins_list.at(4).push_back(product);
-        }
-        else if(world_pose.position.x > -2.28 && world_pose.position.y > -2.96){
-          product.bin_number = 6;
-          bins_list.at(5).push_back(product);
-        }
-        else if(world_pose.position.x < -2.28 && world_pose.position.y > -2.96){
-          product.bin_number = 7;
-          bins_list.at(6).push_back(product);
-        }
-        else if(world_pose.position.x < -2.28 && world_pose.position.y < -2.96){
-          product.bin_number = 8;
-          bins_list.at(7).push_back(product);
-        }
-        camera_parts_list.at(1).push_back(product);
-        i++;
-      }
-     get_cam[1] = false; 
-     }
-}
-
-std::array<std::vector<Product>,19> LogicalCamera::findparts(){
-  ROS_INFO_STREAM("In Findparts");
-  for (int i{0}; i < 18; i++){
-    get_cam[i] = true;
-    camera_parts_list.at(i).clear();
-  }
-  get_cam[18] = false;
-
-  ros::Subscriber logical_camera_bins0_subscriber = node_.subscribe(
-    "/ariac/logical_camera_bins0", 2, 
-    &LogicalCamera::logical_camera_bins0_callback, this);
-
-  ros::Subscriber logical_camera_bins1_subscriber = node_.subscribe(
-    "/ariac/logical_camera_bins1", 2, 
-    &LogicalCamera::logical_camera_bins1_callback, this);
-
-  // ros::Subscriber logical_camera_station1_subscriber = node_.subscribe(
-  //   "/ariac/logical_camera_station1", 2, 
-  //   &LogicalCamera::logical_camera_station1_callback, this);
-
-  // ros::Subscriber logical_camera_station2_subscriber = node_.subscribe(
-  //   "/ariac/logical_camera_station2", 2, 
-  //   &LogicalCamera::logical_camera_station2_callback, this);
-
-  // ros::Subscriber logical_camera_station3_subscriber = node_.subscribe(
-  //   "/ariac/logical_camera_station3", 2, 
-  //   &LogicalCamera::logical_camera_station3_callback, this);
-
-  // ros::Subscriber logical_camera_station4_subscriber = node_.subscribe(
-  //   "/ariac/logical_camera_station4", 2, 
-  //   &LogicalCamera::logical_camera_station4_callback, this);
-
-  ros::Subscriber logical_camera_agv1as1_subscriber = node_.subscribe(
-    "/ariac/logical_camera_agv1as1", 2, 
-    &LogicalCamera::logical_camera_agv1as1_callback, this);
-
-  ros::Subscriber logical_camera_agv1as2_subscriber = node_.subscribe(
-    "/ariac/logical_camera_agv1as2", 2, 
-    &LogicalCamera::logical_camera_agv1as2_callback, this);
-
-  // ros::Subscriber logical_camera_agv1ks_subscriber = node_.subscribe(
-  //   "/ariac/logical_camera_agv1ks", 2, 
-  //   &LogicalCamera::logical_camera_agv1ks_callback, this);
-
-  ros::Subscriber logical_camera_agv2as1_subscriber = node_.subscribe(
-    "/ariac/logical_camera_agv2as1", 2, 
-    &LogicalCamera::logical_camera_agv2as1_callback, this);
-
-  ros::Subscriber logical_camera_agv2as2_subscriber = node_.subscribe(
-    "/ariac/logical_camera_agv2as2", 2, 
-    &LogicalCamera::logical_camera_agv2as2_callback, this);
-
-  // ros::Subscriber logical_camera_agv2ks_subscriber = node_.subscribe(
-  //   "/ariac/logical_camera_agv2ks", 2, 
-  //   &LogicalCamera::logical_camera_agv2ks_callback, this);
-
-  ros::Subscriber logical_camera_agv3as3_subscriber = node_.subscribe(
-    "/ariac/logical_camera_agv3as3", 2, 
-    &LogicalCamera::logical_camera_agv3as3_callback, this);
-
-  ros::Subscriber logical_camera_agv3as4_subscriber = node_.subscribe(
-    "/ariac/logical_camera_agv3as4", 2, 
-    &LogicalCamera::logical_camera_agv3as4_callback, this);
-
-  // ros::Subscriber logical_camera_agv3ks_subscriber = node_.subscribe(
-  //   "/ariac/logical_camera_agv3ks", 2, 
-  //   &LogicalCamera::logical_camera_agv3ks_callback, this);
-
-  ros::Subscriber logical_camera_agv4as3_subscriber = node_.subscribe(
-    "/ariac/logical_camera_agv4as3", 2, 
-    &LogicalCamera::logical_camera_agv4as3_callback, this);
-
-  ros::Subscriber logical_camera_agv4as4_subscriber = node_.subscribe(
-    "/ariac/logical_camera_agv4as4", 2, 
-    &LogicalCamera::logical_camera_agv4as4_callback, this);
-
-  // ros::Subscriber logical_camera_agv4ks_subscriber = node_.subscribe(
-  //   "/ariac/logical_camera_agv4ks", 2, 
-  //   &LogicalCamera::logical_camera_agv4ks_callback, this);
-
-  // ros::Subscriber logical_camera_belt_subscriber = node_.subscribe(
-  //   "/ariac/logical_camera_belt", 2, 
-  //   &LogicalCamera::logical_camera_belt_callback, this);
-
-  ros::Duration(sleep(5.0));
-  return camera_parts_list;  
-
+ros::Subscriber LogicalCamera::subscribe(motioncontrol::SensorId sensor){
+  return node_.subscribe<nist_gear::LogicalCameraImage>(motioncontrol::sensorInfo(sensor).topic, 1,
+    [this, sensor](const nist_gear::LogicalCameraImage::ConstPtr & image_msg){ ingest(sensor, image_msg); });
 }
 
-void LogicalCamera::segregate_parts(std::array<std::vector<Product>,19> list){
-  camera_map_.clear();
-  for (auto &l: list){
-    for(auto &part: l){
-      camera_map_[part.type].push_back(part);
+void LogicalCamera::ingest(motioncontrol::SensorId sensor, const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
+  const auto& info = motioncontrol::sensorInfo(sensor);
+  const std::size_t i = motioncontrol::index(sensor);
+  const bool quality_control = i >= motioncontrol::kLogicalCameraCount;
+  const ros::Time now = ros::Time::now();
+  motioncontrol::SensorHealth::instance().heartbeat(sensor);
+
+  // an unchanged image only refreshes the time of the sensor and ages the parts it stopped seeing
+  auto& signature = next_signatures_.at(i);
+  frame_signature(*image_msg, signature);
+  if (sensor_frames_.at(i).processed > 0 && signature == signatures_.at(i)){
+    sensor_frames_.at(i).skipped++;
+    if (!quality_control){
+      tracker_.unchanged(sensor);
+      motioncontrol::Inventory::instance().apply(tracker_.takeEvents());
     }
+    store_stamp(sensor);
+    return;
   }
-}
-
-std::vector<int> LogicalCamera::get_ebin_list(){
-  for (int i = 0; i < 8; i++){
-    if(bins_list.at(i).size() == 0){
-      empty_bin.push_back(i+1);
+  std::vector<geometry_msgs::Pose> world_poses;
+  if (!motioncontrol::transformImageToWorld(*image_msg, sensor, world_poses))
+    return;
+  signatures_.at(i).swap(signature);
+  sensor_frames_.at(i).processed++;
+
+  // each subscription runs its callbacks one at a time, so the scratch list of the sensor is not shared
+  auto& parts = scratch_.at(i);
+  parts.clear();
+  motioncontrol::TrayId faulty_agv{motioncontrol::TrayId::kCount};
+  if (quality_control)
+    motioncontrol::trayFromLocation(info.agv, faulty_agv);
+  for (std::size_t k{0}; k < image_msg->models.size(); k++){
+    const auto &model = image_msg->models.at(k);
+    Product product;
+    product.type = model.type;
+    product.frame_pose = model.pose;
+    product.camera = sensor;
+    product.time_stamp = now;
+    product.world_pose = world_poses.at(k);
+    if (quality_control){
+      product.faulty = true;
+      product.faulty_agv = faulty_agv;
+    }
+    else{
+      product.status = motioncontrol::PartStatus::kFree;
     }
+    if (info.first_bin)
+      product.bin_number = bin_of(info, product.world_pose);
+    parts.push_back(std::move(product));
   }
-  return empty_bin;
-}
-
-double LogicalCamera::CheckBlackout(){
-  return blackout_time_;
-}
 
+  if (quality_control){
+    ROS_INFO_STREAM("[LogicalCamera] " << parts.size() << " faulty part(s) on " << info.agv);
+    store_faulty_parts(sensor, parts);
+    return;
+  }
 
-void LogicalCamera::quality_control_sensor1_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-    if (get_faulty_cam[0]){
-      if (!image_msg->models.empty()){
-        ROS_INFO_STREAM_THROTTLE(10,"Faulty part detected on agv1");
-
-        for (auto &model:image_msg->models){
-          Product product;
-          product.type = model.type;
-          product.frame_pose = model.pose;
-          product.camera = "quality_control_sensor_1";
-          auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-          product.world_pose = world_pose;
-          product.faulty_cam_agv = "agv1";
-          faulty_part_list_.push_back(product);
-        }
-      }
-      get_faulty_cam[0] = false; 
+  tracker_.update(sensor, parts);
+  motioncontrol::Inventory::instance().apply(tracker_.takeEvents());
+  if (info.scanned)
+    motioncontrol::Inventory::instance().update(sensor, parts);
+  if (sensor == motioncontrol::SensorId::kBelt)
+    motioncontrol::BeltTracker::instance().observe(now, parts);
+  if (info.first_bin){
+    std::array<std::vector<Product>,4> bins;
+    for (const auto& product: parts){
+      if (product.bin_number)
+        bins.at(product.bin_number - info.first_bin).push_back(product);
     }
+    motioncontrol::BinSlots::instance().update(info.first_bin - 1, bins);
+    store_bins(info.first_bin - 1, std::move(bins));
+  }
+  store_parts(sensor, parts);
 }
 
-
-void LogicalCamera::quality_control_sensor2_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-    if (get_faulty_cam[1]){
-      if (!image_msg->models.empty()){
-        ROS_INFO_STREAM_THROTTLE(10,"Faulty part detected on agv2");
-    
-        for (auto &model:image_msg->models){
-          Product product;
-          product.type = model.type;
-          product.frame_pose = model.pose;
-          product.camera = "quality_control_sensor_2";
-          auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-          product.world_pose = world_pose;
-          product.faulty_cam_agv = "agv2";
-          faulty_part_list_.push_back(product);
-        }
-      }
-
-    get_faulty_cam[1] = false;
+void LogicalCamera::init(){
+  for (std::size_t i{0}; i < motioncontrol::kLogicalCameraCount; i++)
+    camera_subscribers_.at(i) = subscribe(motioncontrol::cameraAt(i));
+  for (std::size_t n{0}; n < motioncontrol::kQualityControlCount; n++){
+    if (motioncontrol::sensorInfo(motioncontrol::qualityControlAt(n)).scanned)
+      quality_control_sensor_subscribers_.at(n) = subscribe(motioncontrol::qualityControlAt(n));
   }
 }
 
-
-void LogicalCamera::quality_control_sensor3_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-    if (get_faulty_cam[2]){
-      if (!image_msg->models.empty()){
-        ROS_INFO_STREAM_THROTTLE(10,"Faulty part detected on agv3");
-
-        for (auto &model:image_msg->models){
-          Product product;
-          product.type = model.type;
-          product.frame_pose = model.pose;
-          product.camera = "quality_control_sensor_3";
-          auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-          product.world_pose = world_pose;
-          product.faulty_cam_agv = "agv3";
-          faulty_part_list_.push_back(product);
-        }
-      }
-
-      get_faulty_cam[2] = false;
-    }
+std::vector<motioncontrol::SensorId> LogicalCamera::scanned_cameras(){
+  std::vector<motioncontrol::SensorId> cameras;
+  for (std::size_t i{0}; i < motioncontrol::kLogicalCameraCount; i++){
+    if (motioncontrol::sensorInfo(motioncontrol::cameraAt(i)).scanned)
+      cameras.push_back(motioncontrol::cameraAt(i));
+  }
+  return cameras;
 }
 
-
-void LogicalCamera::quality_control_sensor4_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-    if (get_faulty_cam[3]){
-      if (!image_msg->models.empty()){
-        ROS_INFO_STREAM_THROTTLE(10,"Faulty part detected on agv4");
-
-        for (auto &model:image_msg->models){
-          Product product;
-          product.type = model.type;
-          product.frame_pose = model.pose;
-          product.camera = "quality_control_sensor_4";
-          auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-          product.world_pose = world_pose;
-          product.faulty_cam_agv = "agv4";
-          faulty_part_list_.push_back(product);
-        }
-      }
-
-    get_faulty_cam[3] = false;
-    }
+std::future<ScanResult> LogicalCamera::scan(const std::vector<motioncontrol::SensorId>& cameras, const ros::Time& deadline){
+  const ros::Time requested = ros::Time::now();
+  return std::async(std::launch::async, &LogicalCamera::wait_for_scan, this, cameras, requested, deadline);
 }
 
-std::vector<Product> LogicalCamera::get_faulty_part_list(){
- 
-  quality_control_sensor1_subscriber = node_.subscribe("/ariac/quality_control_sensor_1", 1, &LogicalCamera::quality_control_sensor1_callback, this);
-
-  quality_control_sensor2_subscriber = node_.subscribe("/ariac/quality_control_sensor_2", 1, &LogicalCamera::quality_control_sensor2_callback, this);
-
-  quality_control_sensor3_subscriber = node_.subscribe("/ariac/quality_control_sensor_3", 1, &LogicalCamera::quality_control_sensor3_callback, this);
-
-  quality_control_sensor4_subscriber = node_.subscribe("/ariac/quality_control_sensor_4", 1, &LogicalCamera::quality_control_sensor4_callback, this);
-    
-  return faulty_part_list_;
+ScanResult LogicalCamera::wait_for_scan(const std::vector<motioncontrol::SensorId>& cameras, const ros::Time& requested, const ros::Time& deadline){
+  ScanResult result;
+  auto world = world_.load();
+  std::unique_lock<std::mutex> lock(frame_mutex_);
+  motioncontrol::SimClock::instance().waitUntil(frame_arrived_, lock, deadline, [&](){
+    world = world_.load();
+    result.late.clear();
+    for (auto camera: cameras){
+      if (world->value.stamps.at(motioncontrol::index(camera)) <= requested)
+        result.late.push_back(camera);
+    }
+    result.stale = motioncontrol::SensorHealth::instance().blackout();
+    return result.late.empty() || result.stale;
+  });
+  lock.unlock();
+  for (auto camera: cameras)
+    result.parts.at(motioncontrol::index(camera)) = *world->value.parts.at(motioncontrol::index(camera));
+  if (result.stale){
+    ROS_WARN_STREAM("[LogicalCamera] sensor blackout, the scan returns the last known parts");
+  }
+  else{
+    for (auto camera: result.late)
+      ROS_WARN_STREAM("[LogicalCamera] no new image from " << motioncontrol::sensorInfo(camera).name << " before the scan deadline");
+  }
+  return result;
 }
 
-void LogicalCamera::query_faulty_cam(){
-  faulty_part_list_.clear();
-  for (int j{0}; j <= 3; j++){  
-    get_faulty_cam[j] = true;
+std::array<std::vector<Product>,motioncontrol::kLogicalCameraCount> LogicalCamera::findparts(){
+  std::array<std::vector<Product>,motioncontrol::kLogicalCameraCount> list;
+  const auto world = world_.load();
+  for (std::size_t i{0}; i < motioncontrol::kLogicalCameraCount; i++){
+    if (motioncontrol::sensorInfo(motioncontrol::cameraAt(i)).scanned)
+      list.at(i) = *world->value.parts.at(i);
   }
-  
+  return list;
 }
 
-void LogicalCamera::logical_camera_station1_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-    // ROS_INFO_STREAM_THROTTLE(10,"Logical camera station 1: '" << image_msg->models.size() << "' objects.");
-    if (get_cam[2])
-     { 
-      ros::Duration timeout(5.0);
-      unsigned short int i{0};
-      while(i < image_msg->models.size())
-      {
-        std::string product_type = image_msg->models.at(i).type;
-        Product product;
-        product.type = product_type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_station1";
-        product.status = "free";
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        camera_parts_list.at(2).push_back(product);
-        i++;
-      }
-     get_cam[2] = false; 
-     }
-}   
-
-void LogicalCamera::logical_camera_station2_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-    // ROS_INFO_STREAM_THROTTLE(10,"Logical camera station 2: '" << image_msg->models.size() << "' objects.");
-    if (get_cam[3])
-     { 
-      ros::Duration timeout(5.0);
-      unsigned short int i{0};
-      while(i < image_msg->models.size())
-      {
-        std::string product_type = image_msg->models.at(i).type;
-        Product product;
-        product.type = product_type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_station2";
-        product.status = "free";
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        camera_parts_list.at(3).push_back(product);
-        i++;
-      }
-     get_cam[3] = false; 
-     }
+std::vector<Product> LogicalCamera::get_parts(motioncontrol::SensorId camera){
+  return *world_.load()->value.parts.at(motioncontrol::index(camera));
 }
 
-void LogicalCamera::logical_camera_station3_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-    // ROS_INFO_STREAM_THROTTLE(10,"Logical camera station 3: '" << image_msg->models.size() << "' objects.");
-    if (get_cam[4])
-     { 
-      ros::Duration timeout(5.0);
-      unsigned short int i{0};
-      while(i < image_msg->models.size())
-      {
-        std::string product_type = image_msg->models.at(i).type;
-        Product product;
-        product.type = product_type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_station3";
-        product.status = "free";
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        camera_parts_list.at(4).push_back(product);
-        i++;
-      }
-     get_cam[4] = false; 
-     }
-
+ros::Time LogicalCamera::get_stamp(motioncontrol::SensorId camera){
+  return world_.load()->value.stamps.at(motioncontrol::index(camera));
 }
 
-void LogicalCamera::logical_camera_station4_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-    // ROS_INFO_STREAM_THROTTLE(10,"Logical camera station 4: '" << image_msg->models.size() << "' objects.");
-    if (get_cam[5])
-     { 
-      ros::Duration timeout(5.0);
-
-      unsigned short int i{0};
-      while(i < image_msg->models.size())
-      {
-        std::string product_type = image_msg->models.at(i).type;
-        Product product;
-        product.type = product_type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_station4";
-        product.status = "free";
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        camera_parts_list.at(5).push_back(product);
-        i++;
-      }
-      
-     get_cam[5] = false; 
-     }
-
-}
-void LogicalCamera::logical_camera_agv1as1_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-  if (get_cam[6])
-     { 
-      ros::Duration timeout(5.0);
-      unsigned short int i{0}; 
-      while(i < image_msg->models.size())
-      {
-        Product product;
-        product.type = image_msg->models.at(i).type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_agv1as1";
-        product.status = "free";
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        camera_parts_list.at(6).push_back(product);
-        i++;
-      }
-      
-     get_cam[6] = false; 
-     }
+void LogicalCamera::notify_frame(){
+  // taking the mutex orders the notification after a waiter that just checked the stamps
+  { std::lock_guard<std::mutex> lock(frame_mutex_); }
+  frame_arrived_.notify_all();
 }
 
-void LogicalCamera::logical_camera_agv1as2_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-  if (get_cam[7])
-     { 
-      ros::Duration timeout(5.0);
-      unsigned short int i{0};
-      while(i < image_msg->models.size())
-      {
-        Product product;
-        product.type = image_msg->models.at(i).type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_agv1as2";
-        product.status = "free";
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        camera_parts_list.at(7).push_back(product);
-        i++;
-      }
-      
-     get_cam[7] = false; 
-     }
+void LogicalCamera::store_stamp(motioncontrol::SensorId sensor){
+  const ros::Time now = ros::Time::now();
+  world_.update([sensor, now](WorldModel& world){
+    world.stamps.at(motioncontrol::index(sensor)) = now;
+  });
+  notify_frame();
 }
 
-void LogicalCamera::logical_camera_agv1ks_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-  if (get_cam[8])
-     { 
-      ros::Duration timeout(5.0);
-      unsigned short int i{0};
-      while(i < image_msg->models.size())
-      {
-        std::string product_type = image_msg->models.at(i).type;
-        Product product;
-        product.type = product_type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_agv1ks";
-        product.status = "free";
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        camera_parts_list.at(8).push_back(product);
-        i++;
-      }     
-     get_cam[8] = false; 
-     }
+LogicalCamera::FrameCounters LogicalCamera::get_frame_counters(motioncontrol::SensorId sensor){
+  const auto& counters = sensor_frames_.at(motioncontrol::index(sensor));
+  return FrameCounters{counters.processed.load(), counters.skipped.load()};
 }
 
-void LogicalCamera::logical_camera_agv2as1_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-  if (get_cam[9])
-     { 
-      ros::Duration timeout(5.0);
-      unsigned short int i{0};
-      while(i < image_msg->models.size())
-      {
-        Product product;
-        product.type = image_msg->models.at(i).type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_agv2as1";
-        product.status = "free";
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        camera_parts_list.at(9).push_back(product);
-        i++;
-      }
-      
-     get_cam[9] = false; 
-     }
+void LogicalCamera::store_parts(motioncontrol::SensorId camera, std::vector<Product>& parts){
+  // the list is built outside the update so the writers are serialized for a few pointer copies only
+  auto list = std::make_shared<const std::vector<Product> >(std::move(parts));
+  const ros::Time now = ros::Time::now();
+  world_.update([camera, now, &list](WorldModel& world){
+    world.parts.at(motioncontrol::index(camera)) = std::move(list);
+    world.stamps.at(motioncontrol::index(camera)) = now;
+  });
+  notify_frame();
 }
 
-void LogicalCamera::logical_camera_agv2as2_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-  if (get_cam[10])
-     { 
-      ros::Duration timeout(5.0);
-      unsigned short int i{0};
-      while(i < image_msg->models.size())
-      {
-        Product product;
-        product.type = image_msg->models.at(i).type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_agv2as2";
-        product.status = "free";
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        camera_parts_list.at(10).push_back(product);
-        i++;
-      }
-     get_cam[10] = false; 
-     }
+void LogicalCamera::store_bins(std::size_t first_bin, std::array<std::vector<Product>,4>&& bins){
+  std::array<WorldModel::PartList,4> lists;
+  for (std::size_t i{0}; i < bins.size(); i++)
+    lists.at(i) = std::make_shared<const std::vector<Product> >(std::move(bins.at(i)));
+  world_.update([first_bin, &lists](WorldModel& world){
+    for (std::size_t i{0}; i < lists.size(); i++)
+      world.bins.at(first_bin + i) = std::move(lists.at(i));
+  });
 }
 
-void LogicalCamera::logical_camera_agv2ks_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-  if (get_cam[11])
-     {
-      ros::Duration timeout(5.0);
-      unsigned short int i{0};
-      while(i < image_msg->models.size())
-      {
-        std::string product_type = image_msg->models.at(i).type;
-        Product product;
-        product.type = product_type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_agv2ks";
-        product.status = "free";
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        camera_parts_list.at(11).push_back(product);
-        i++; 
-      }
-     get_cam[11] = false; 
-     }
+void LogicalCamera::segregate_parts(std::array<std::vector<Product>,motioncontrol::kLogicalCameraCount> list){
+  camera_map_.clear();
+  for (auto &l: list){
+    for(auto &part: l){
+      camera_map_[part.type].push_back(part);
+    }
+  }
 }
 
-void LogicalCamera::logical_camera_agv3as3_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-  if (get_cam[12])
-     { 
-      ros::Duration timeout(5.0);
-      unsigned short int i{0};
-      while(i < image_msg->models.size())
-      {
-        Product product;
-        product.type = image_msg->models.at(i).type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_agv3as3";
-        product.status = "free";
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        camera_parts_list.at(12).push_back(product);
-        i++;
-      }
-     get_cam[12] = false; 
-     }
+std::array<std::vector<Product>,8> LogicalCamera::get_bin_list(){
+  std::array<std::vector<Product>,8> bins;
+  const auto world = world_.load();
+  for (std::size_t i{0}; i < bins.size(); i++)
+    bins.at(i) = *world->value.bins.at(i);
+  return bins;
 }
 
-void LogicalCamera::logical_camera_agv3as4_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-  if (get_cam[13])
-     { 
-      ros::Duration timeout(5.0);
-      unsigned short int i{0}; 
-      while(i < image_msg->models.size())
-      {
-        Product product;
-        product.type = image_msg->models.at(i).type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_agv3as4";
-        product.status = "free";
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        camera_parts_list.at(13).push_back(product);
-        i++;
-      }
-     get_cam[13] = false; 
-     }
+std::vector<int> LogicalCamera::get_ebin_list(){
+  std::vector<int> empty_bins;
+  const auto world = world_.load();
+  for (int i = 0; i < 8; i++){
+    if(world->value.bins.at(i)->empty()){
+      empty_bins.push_back(i+1);
+    }
+  }
+  return empty_bins;
 }
 
-void LogicalCamera::logical_camera_agv3ks_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-  if (get_cam[14])
-     { 
-      ros::Duration timeout(5.0);
-
-      unsigned short int i{0};
-      while(i < image_msg->models.size())
-      {
-        Product product;
-        product.type = image_msg->models.at(i).type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_agv3ks";
-        product.status = "free";
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        camera_parts_list.at(14).push_back(product);
-        i++;
-      }
-     get_cam[14] = false; 
-     }
-}
 
-void LogicalCamera::logical_camera_agv4as3_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-  if (get_cam[15])
-     { 
-      ros::Duration timeout(5.0);
-      unsigned short int i{0}; 
-      while(i < image_msg->models.size())
-      {
-        Product product;
-        product.type = image_msg->models.at(i).type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_agv4as3";
-        product.status = "free";
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        camera_parts_list.at(15).push_back(product);
-        i++; 
-      }
-     get_cam[15] = false; 
-     }
+void LogicalCamera::store_faulty_parts(motioncontrol::SensorId sensor, std::vector<Product>& parts){
+  auto list = std::make_shared<const std::vector<Product> >(std::move(parts));
+  const ros::Time now = ros::Time::now();
+  world_.update([sensor, now, &list](WorldModel& world){
+    world.faulty_parts.at(motioncontrol::index(sensor) - motioncontrol::kLogicalCameraCount) = std::move(list);
+    world.stamps.at(motioncontrol::index(sensor)) = now;
+  });
+  notify_frame();
 }
 
-void LogicalCamera::logical_camera_agv4as4_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-  if (get_cam[16])
-     { 
-      ros::Duration timeout(5.0);
-      unsigned short int i{0};
-      while(i < image_msg->models.size())
-      {
-        Product product;
-        product.type = image_msg->models.at(i).type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_agv4as4";
-        product.status = "free";
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        camera_parts_list.at(16).push_back(product);
-        i++;
-      }
-     get_cam[16] = false; 
-     }
+bool LogicalCamera::quality_control_of(const std::string& agv, std::size_t& n){
+  for (n = 0; n < motioncontrol::kQualityControlCount; n++){
+    if (agv == motioncontrol::sensorInfo(motioncontrol::qualityControlAt(n)).agv)
+      return true;
+  }
+  ROS_WARN_STREAM("[LogicalCamera] no quality control sensor watches " << agv);
+  return false;
 }
 
-void LogicalCamera::logical_camera_agv4ks_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-  if (get_cam[17])
-     { 
-      ros::Duration timeout(5.0);
-      unsigned short int i{0};
-      while(i < image_msg->models.size())
-      {
-        Product product;
-        product.type = image_msg->models.at(i).type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_agv4ks";
-        product.status = "free";
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        camera_parts_list.at(17).push_back(product);
-        i++;
-      }
-     get_cam[17] = false; 
-     }
+std::vector<Product> LogicalCamera::get_faulty_parts(const std::string& agv){
+  std::size_t n;
+  if (!quality_control_of(agv, n))
+    return {};
+  return *world_.load()->value.faulty_parts.at(n);
 }
 
-void LogicalCamera::logical_camera_belt_callback(const nist_gear::LogicalCameraImage::ConstPtr & image_msg){
-  if (get_cam[18])
-     { 
-      ros::Duration timeout(5.0);
-      unsigned short int i{0};
-      while(i < image_msg->models.size())
-      {
-        Product product;
-        product.type = image_msg->models.at(i).type;
-        product.frame_pose = image_msg->models.at(i).pose;
-        product.camera = "logical_camera_belt";
-        product.status = "free";
-        auto world_pose = motioncontrol::gettransforminWorldFrame(product.frame_pose, product.camera);
-        product.world_pose = world_pose;
-        camera_parts_list.at(18).push_back(product);
-        i++;
-      }
-     get_cam[18] = false; 
-     }
-}
\ No newline at end of file
+bool LogicalCamera::wait_for_faulty_part(const std::string& agv, const geometry_msgs::Pose& placed,
+  const ros::Duration& timeout, Product& faulty){
+  std::size_t n;
+  if (!quality_control_of(agv, n))
+    return false;
+  if (motioncontrol::SensorHealth::instance().blackout()){
+    ROS_WARN_STREAM("[LogicalCamera] sensor blackout, no verdict for the part placed on " << agv);
+    return false;
+  }
+  const std::size_t i = motioncontrol::index(motioncontrol::qualityControlAt(n));
+  const ros::Time requested = ros::Time::now();
+  const ros::Time deadline = requested + timeout;
+
+  auto world = world_.load();
+  std::unique_lock<std::mutex> lock(frame_mutex_);
+  motioncontrol::SimClock::instance().waitUntil(frame_arrived_, lock, deadline, [&](){
+    world = world_.load();
+    return world->value.stamps.at(i) > requested;
+  });
+  lock.unlock();
+  const bool fresh = world->value.stamps.at(i) > requested;
+
+  // the faulty part closest to the placement
+  const std::vector<Product>& parts = *world->value.faulty_parts.at(n);
+  double best = std::numeric_limits<double>::max();
+  for (const auto& part: parts){
+    const double dx = part.world_pose.position.x - placed.position.x;
+    const double dy = part.world_pose.position.y - placed.position.y;
+    if (dx * dx + dy * dy < best){
+      best = dx * dx + dy * dy;
+      faulty = part;
+    }
+  }
+  const bool found = best < kFaultMatchRadius * kFaultMatchRadius;
+
+  if (!fresh)
+    ROS_WARN_STREAM("[LogicalCamera] no new image from " << motioncontrol::sensorInfo(motioncontrol::qualityControlAt(n)).name
+      << " within " << timeout.toSec() << " s, using the previous one");
+  return found;
+}
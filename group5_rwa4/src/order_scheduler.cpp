@@ -0,0 +1,131 @@
+#include "../include/comp/order_scheduler.h"
+#include "../include/util/sim_clock.h"
+#include <algorithm>
+
+namespace motioncontrol {
+
+    constexpr unsigned short int OrderScheduler::kNormalPriority;
+    constexpr unsigned short int OrderScheduler::kHighPriority;
+
+    OrderScheduler& OrderScheduler::instance()
+    {
+        static OrderScheduler scheduler;
+        return scheduler;
+    }
+
+    bool OrderScheduler::lessUrgent(const TaskPtr& a, const TaskPtr& b)
+    {
+        if (a->priority != b->priority)
+            return a->priority < b->priority;
+        // a suspended shipment resumes before the others of its priority
+        if ((a->runs > 0) != (b->runs > 0))
+            return b->runs > 0;
+        return a->sequence > b->sequence;
+    }
+
+    unsigned short int OrderScheduler::announcePriority() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return heap_.empty() && !running_ ? kNormalPriority : kHighPriority;
+    }
+
+    void OrderScheduler::submit(const Order& order)
+    {
+        const ros::Time now = ros::Time::now();
+        std::vector<TaskPtr> tasks;
+        for (const auto& kit : order.kitting) {
+            auto task = std::make_shared<ShipmentTask>();
+            task->kind = ShipmentTask::Kind::kKitting;
+            task->shipment_type = kit.shipment_type;
+            task->destination = kit.agv_id;
+            task->station_id = kit.station_id;
+            task->products = kit.products;
+            tasks.push_back(task);
+        }
+        for (const auto& asmb : order.assembly) {
+            auto task = std::make_shared<ShipmentTask>();
+            task->kind = ShipmentTask::Kind::kAssembly;
+            task->shipment_type = asmb.shipment_type;
+            task->destination = asmb.stations;
+            task->products = asmb.products;
+            tasks.push_back(task);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& task : tasks) {
+            task->order_id = order.order_id;
+            task->priority = order.priority;
+            task->sequence = sequence_++;
+            task->announced = now;
+            for (auto& product : task->products)
+                product.processed = false;
+            heap_.push_back(task);
+            std::push_heap(heap_.begin(), heap_.end(), &OrderScheduler::lessUrgent);
+        }
+        remaining_[order.order_id] += tasks.size();
+        ROS_INFO_STREAM("[OrderScheduler] " << order.order_id << " queued with priority " << order.priority
+            << ", " << tasks.size() << " shipment(s)");
+        queued_.notify_all();
+    }
+
+    OrderScheduler::TaskPtr OrderScheduler::next()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (heap_.empty())
+            return nullptr;
+        std::pop_heap(heap_.begin(), heap_.end(), &OrderScheduler::lessUrgent);
+        running_ = heap_.back();
+        heap_.pop_back();
+        if (running_->runs++ == 0) {
+            ROS_INFO_STREAM("[OrderScheduler] " << running_->shipment_type << " of " << running_->order_id
+                << " started " << (ros::Time::now() - running_->announced).toSec() << " s after it was announced");
+        }
+        else {
+            ROS_INFO_STREAM("[OrderScheduler] " << running_->shipment_type << " of " << running_->order_id << " resumed");
+        }
+        return running_;
+    }
+
+    bool OrderScheduler::preempt(const ShipmentTask& task) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return !heap_.empty() && heap_.front()->priority > task.priority;
+    }
+
+    void OrderScheduler::suspend(const TaskPtr& task)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!heap_.empty())
+            ROS_INFO_STREAM("[OrderScheduler] " << task->shipment_type << " of " << task->order_id
+                << " suspended for " << heap_.front()->order_id);
+        if (running_ == task)
+            running_.reset();
+        heap_.push_back(task);
+        std::push_heap(heap_.begin(), heap_.end(), &OrderScheduler::lessUrgent);
+    }
+
+    void OrderScheduler::complete(const TaskPtr& task)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_ == task)
+            running_.reset();
+        auto left = remaining_.find(task->order_id);
+        if (left != remaining_.end() && --left->second == 0) {
+            ROS_INFO_STREAM("[OrderScheduler] " << task->order_id << " done "
+                << (ros::Time::now() - task->announced).toSec() << " s after it was announced");
+            remaining_.erase(left);
+        }
+    }
+
+    bool OrderScheduler::waitForWork(const ros::Time& deadline) const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return SimClock::instance().waitUntil(queued_, lock, deadline, [this] { return !heap_.empty(); });
+    }
+
+    bool OrderScheduler::idle() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return heap_.empty() && !running_;
+    }
+}  // namespace motioncontrol
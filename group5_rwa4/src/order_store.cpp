@@ -0,0 +1,24 @@
+#include "../include/comp/order_store.h"
+#include "../include/util/sim_clock.h"
+
+namespace motioncontrol {
+
+    OrderStore::Ptr OrderStore::add(Order order)
+    {
+        OrderPtr added = std::make_shared<const Order>(std::move(order));
+        Ptr published = orders_.update([&added](Orders& orders) { orders.push_back(std::move(added)); });
+        {
+            // a waiter between its version check and its wait still gets woken
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        changed_.notify_all();
+        return published;
+    }
+
+    OrderStore::Ptr OrderStore::waitForChange(std::uint64_t version, const ros::Time& deadline) const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        SimClock::instance().waitUntil(changed_, lock, deadline, [&] { return orders_.load()->version != version; });
+        return orders_.load();
+    }
+}  // namespace motioncontrol
@@ -0,0 +1,143 @@
+#include "../include/camera/part_index.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace motioncontrol {
+
+    namespace {
+        std::int64_t cellKey(int cx, int cy)
+        {
+            return (static_cast<std::int64_t>(cx) << 32) | static_cast<std::uint32_t>(cy);
+        }
+
+        double squaredDistance(const Product& part, const geometry_msgs::Point& p)
+        {
+            const double dx = part.world_pose.position.x - p.x;
+            const double dy = part.world_pose.position.y - p.y;
+            return dx * dx + dy * dy;
+        }
+    }  // namespace
+
+    constexpr double PartIndex::kCellSize;
+
+    void PartIndex::Grid::insert(int cx, int cy, Product* part)
+    {
+        if (cells.empty()) {
+            min_x = max_x = cx;
+            min_y = max_y = cy;
+        }
+        min_x = std::min(min_x, cx);
+        max_x = std::max(max_x, cx);
+        min_y = std::min(min_y, cy);
+        max_y = std::max(max_y, cy);
+        cells[cellKey(cx, cy)].push_back(part);
+    }
+
+    const std::vector<Product*>* PartIndex::Grid::find(int cx, int cy) const
+    {
+        if (cx < min_x || cx > max_x || cy < min_y || cy > max_y)
+            return nullptr;
+        auto cell = cells.find(cellKey(cx, cy));
+        return cell == cells.end() ? nullptr : &cell->second;
+    }
+
+    int PartIndex::cellOf(double v)
+    {
+        return static_cast<int>(std::floor(v / kCellSize));
+    }
+
+    PartIndex::PartIndex(std::map<std::string, std::vector<Product> >& parts)
+    {
+        for (auto& type : parts) {
+            for (auto& part : type.second)
+                add(part);
+        }
+    }
+
+    PartIndex::PartIndex(std::map<std::string, std::vector<Product> >& parts, const std::vector<SensorId>& cameras)
+    {
+        for (auto& type : parts) {
+            for (auto& part : type.second) {
+                if (std::find(cameras.begin(), cameras.end(), part.camera) != cameras.end())
+                    add(part);
+            }
+        }
+    }
+
+    void PartIndex::add(Product& part)
+    {
+        const int cx = cellOf(part.world_pose.position.x);
+        const int cy = cellOf(part.world_pose.position.y);
+        all_.insert(cx, cy, &part);
+        by_type_[part.type].insert(cx, cy, &part);
+        if (part.bin_number > 0)
+            by_bin_[part.bin_number].push_back(&part);
+        size_++;
+    }
+
+    Product* PartIndex::nearestFree(PartType type, const geometry_msgs::Point& from) const
+    {
+        auto found = by_type_.find(type);
+        if (found == by_type_.end() || found->second.cells.empty())
+            return nullptr;
+        const Grid& grid = found->second;
+        const int cx = cellOf(from.x);
+        const int cy = cellOf(from.y);
+        // rings of cells around the start cell, up to the farthest occupied cell
+        const int last_ring = std::max(std::max(std::abs(grid.min_x - cx), std::abs(grid.max_x - cx)),
+                                       std::max(std::abs(grid.min_y - cy), std::abs(grid.max_y - cy)));
+
+        Product* best = nullptr;
+        double best_distance = std::numeric_limits<double>::max();
+        for (int ring = 0; ring <= last_ring; ring++) {
+            for (int x = cx - ring; x <= cx + ring; x++) {
+                // inner rows of the ring only have their two end cells
+                const int step = (x == cx - ring || x == cx + ring) ? 1 : std::max(2 * ring, 1);
+                for (int y = cy - ring; y <= cy + ring; y += step) {
+                    const auto* cell = grid.find(x, y);
+                    if (!cell)
+                        continue;
+                    for (Product* part : *cell) {
+                        if (part->status != PartStatus::kFree)
+                            continue;
+                        const double distance = squaredDistance(*part, from);
+                        if (distance < best_distance) {
+                            best_distance = distance;
+                            best = part;
+                        }
+                    }
+                }
+            }
+            // every cell of the next ring is at least ring * kCellSize away
+            const double next = ring * kCellSize;
+            if (best && best_distance <= next * next)
+                break;
+        }
+        return best;
+    }
+
+    std::vector<Product*> PartIndex::inBin(int bin) const
+    {
+        auto found = by_bin_.find(bin);
+        return found == by_bin_.end() ? std::vector<Product*>() : found->second;
+    }
+
+    std::vector<Product*> PartIndex::within(const geometry_msgs::Point& center, double radius) const
+    {
+        std::vector<Product*> parts;
+        const double squared_radius = radius * radius;
+        for (int x = cellOf(center.x - radius); x <= cellOf(center.x + radius); x++) {
+            for (int y = cellOf(center.y - radius); y <= cellOf(center.y + radius); y++) {
+                const auto* cell = all_.find(x, y);
+                if (!cell)
+                    continue;
+                for (Product* part : *cell) {
+                    if (squaredDistance(*part, center) <= squared_radius)
+                        parts.push_back(part);
+                }
+            }
+        }
+        return parts;
+    }
+}  // namespace motioncontrol
@@ -0,0 +1,134 @@
+#include "../include/camera/part_tracker.h"
+#include <algorithm>
+#include <tuple>
+
+namespace motioncontrol {
+
+    namespace {
+        double squaredDistance(const geometry_msgs::Pose& a, const geometry_msgs::Pose& b)
+        {
+            const double dx = a.position.x - b.position.x;
+            const double dy = a.position.y - b.position.y;
+            const double dz = a.position.z - b.position.z;
+            return dx * dx + dy * dy + dz * dz;
+        }
+    }  // namespace
+
+    constexpr double PartTracker::kGate;
+    constexpr double PartTracker::kMoveThreshold;
+    constexpr int PartTracker::kMissedFrames;
+    constexpr std::size_t PartTracker::kMaxEvents;
+
+    void PartTracker::update(SensorId camera, std::vector<Product>& detections)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // candidate pairs within the gate, closest first
+        std::vector<std::tuple<double, Track*, std::size_t> > pairs;
+        for (auto& entry : tracks_) {
+            for (std::size_t d = 0; d < detections.size(); d++) {
+                if (entry.second.part.type != detections[d].type)
+                    continue;
+                const double distance = squaredDistance(entry.second.part.world_pose, detections[d].world_pose);
+                if (distance <= kGate * kGate)
+                    pairs.emplace_back(distance, &entry.second, d);
+            }
+        }
+        std::sort(pairs.begin(), pairs.end(),
+            [](const std::tuple<double, Track*, std::size_t>& a, const std::tuple<double, Track*, std::size_t>& b) {
+                return std::get<0>(a) < std::get<0>(b);
+            });
+
+        std::vector<bool> detection_matched(detections.size(), false);
+        std::map<const Track*, bool> track_matched;
+        for (const auto& pair : pairs) {
+            Track* track = std::get<1>(pair);
+            const std::size_t d = std::get<2>(pair);
+            if (detection_matched[d] || track_matched[track])
+                continue;
+            detection_matched[d] = true;
+            track_matched[track] = true;
+
+            auto& detection = detections[d];
+            detection.id = track->part.id;
+            track->part = detection;
+            track->camera = camera;
+            track->missed = 0;
+            // measured from the last reported pose so slow drifts still add up to a move
+            if (squaredDistance(track->reported, detection.world_pose) > kMoveThreshold * kMoveThreshold) {
+                track->reported = detection.world_pose;
+                emit(PartEvent::Type::kMoved, detection);
+            }
+        }
+
+        // tracks of this camera that it no longer sees
+        countMisses(camera, [&track_matched](const Track& track) { return !track_matched[&track]; });
+
+        for (std::size_t d = 0; d < detections.size(); d++) {
+            if (detection_matched[d])
+                continue;
+            auto& detection = detections[d];
+            detection.id = next_id_++;
+            tracks_[detection.id] = Track{ detection, detection.world_pose, camera, 0 };
+            emit(PartEvent::Type::kAppeared, detection);
+        }
+    }
+
+    void PartTracker::unchanged(SensorId camera)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        countMisses(camera, [](const Track& track) { return track.missed > 0; });
+    }
+
+    template <class Missed>
+    void PartTracker::countMisses(SensorId camera, Missed missed)
+    {
+        for (auto entry = tracks_.begin(); entry != tracks_.end();) {
+            Track& track = entry->second;
+            if (track.camera == camera && missed(track) && ++track.missed >= kMissedFrames) {
+                emit(PartEvent::Type::kDisappeared, track.part);
+                entry = tracks_.erase(entry);
+            }
+            else {
+                ++entry;
+            }
+        }
+    }
+
+    void PartTracker::emit(PartEvent::Type type, const Product& part)
+    {
+        if (events_.size() == kMaxEvents) {
+            ROS_WARN_STREAM_THROTTLE(10, "[PartTracker] event queue full, dropping the oldest events");
+            events_.pop_front();
+        }
+        events_.push_back(PartEvent{ type, part });
+    }
+
+    std::vector<PartEvent> PartTracker::takeEvents()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<PartEvent> events(events_.begin(), events_.end());
+        events_.clear();
+        return events;
+    }
+
+    std::vector<Product> PartTracker::parts() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<Product> parts;
+        parts.reserve(tracks_.size());
+        for (const auto& entry : tracks_)
+            parts.push_back(entry.second.part);
+        return parts;
+    }
+
+    bool PartTracker::find(std::uint32_t id, Product& part) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto track = tracks_.find(id);
+        if (track == tracks_.end())
+            return false;
+        part = track->second.part;
+        return true;
+    }
+}  // namespace motioncontrol
@@ -0,0 +1,54 @@
+#include "../include/util/part_type.h"
+#include <array>
+#include <mutex>
+#include <unordered_map>
+#include <ros/ros.h>
+
+namespace motioncontrol {
+
+    namespace {
+        /**
+         * @brief Side table of the type names
+         *
+         * A name is written once, before its index is handed out, and never
+         * changes, so names are read without locking.
+         */
+        struct TypeTable {
+            std::mutex mutex;
+            std::unordered_map<std::string, std::uint16_t> ids{ { "", 0 } };
+            std::array<std::string, PartType::kMaxTypes> names;
+            std::size_t count{1};
+        };
+
+        TypeTable& table()
+        {
+            static TypeTable types;
+            return types;
+        }
+    }  // namespace
+
+    constexpr std::size_t PartType::kMaxTypes;
+
+    PartType::PartType(const std::string& name)
+    {
+        auto& types = table();
+        std::lock_guard<std::mutex> lock(types.mutex);
+        auto known = types.ids.find(name);
+        if (known != types.ids.end()) {
+            id_ = known->second;
+            return;
+        }
+        if (types.count == kMaxTypes) {
+            ROS_ERROR_STREAM("[PartType] more than " << kMaxTypes << " part types, " << name << " is dropped");
+            return;
+        }
+        id_ = static_cast<std::uint16_t>(types.count++);
+        types.names[id_] = name;
+        types.ids.emplace(name, id_);
+    }
+
+    const std::string& PartType::name() const
+    {
+        return table().names[id_];
+    }
+}  // namespace motioncontrol
@@ -0,0 +1,54 @@
+#include "../include/util/point_batch.h"
+
+namespace motioncontrol {
+
+    void PointBatch::resize(std::size_t n)
+    {
+        if (n > x.size()) {
+            for (auto* v : { &x, &y, &z })
+                v->resize(n);
+        }
+        size_ = n;
+    }
+
+    void PointBatch::assign(const std::vector<geometry_msgs::Point32>& points)
+    {
+        resize(points.size());
+        for (std::size_t i = 0; i < size_; i++) {
+            x[i] = points[i].x;
+            y[i] = points[i].y;
+            z[i] = points[i].z;
+        }
+    }
+
+    void transformPoints(const tf2::Transform& frame_in_world, const PointBatch& in, PointBatch& out)
+    {
+        const std::size_t n = in.size();
+        out.resize(n);
+        if (n == 0)
+            return;
+
+        const tf2::Matrix3x3 r(frame_in_world.getRotation());
+        const tf2::Vector3 r0 = r.getRow(0), r1 = r.getRow(1), r2 = r.getRow(2);
+        const tf2::Vector3& t = frame_in_world.getOrigin();
+        const float r00 = r0.x(), r01 = r0.y(), r02 = r0.z();
+        const float r10 = r1.x(), r11 = r1.y(), r12 = r1.z();
+        const float r20 = r2.x(), r21 = r2.y(), r22 = r2.z();
+        const float tx = t.x(), ty = t.y(), tz = t.z();
+
+        const float* ix = in.x.data();
+        const float* iy = in.y.data();
+        const float* iz = in.z.data();
+        float* ox = out.x.data();
+        float* oy = out.y.data();
+        float* oz = out.z.data();
+
+        // no dependency between iterations, NaN points stay NaN
+        for (std::size_t i = 0; i < n; i++) {
+            const float x = ix[i], y = iy[i], z = iz[i];
+            ox[i] = r00 * x + r01 * y + r02 * z + tx;
+            oy[i] = r10 * x + r11 * y + r12 * z + ty;
+            oz[i] = r20 * x + r21 * y + r22 * z + tz;
+        }
+    }
+}  // namespace motioncontrol
@@ -0,0 +1,45 @@
+#include "../include/util/registry.h"
+#include <cstring>
+
+namespace motioncontrol {
+
+    constexpr SensorInfo Registry::sensors[];
+    constexpr TrayInfo Registry::trays[];
+    constexpr ArmPresetInfo Registry::arm_presets[];
+
+    // The string lookups only run where a name enters the node (config,
+    // orders), the tables are small enough for a linear search.
+
+    bool sensorFromName(const std::string& name, SensorId& id)
+    {
+        for (const auto& sensor : Registry::sensors) {
+            if (std::strcmp(sensor.name, name.c_str()) == 0) {
+                id = sensor.id;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool trayFromLocation(const std::string& location, TrayId& id)
+    {
+        for (const auto& tray : Registry::trays) {
+            if (std::strcmp(tray.location, location.c_str()) == 0) {
+                id = tray.id;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool armPresetFromName(const std::string& name, ArmPreset& id)
+    {
+        for (const auto& preset : Registry::arm_presets) {
+            if (std::strcmp(preset.name, name.c_str()) == 0) {
+                id = preset.id;
+                return true;
+            }
+        }
+        return false;
+    }
+}  // namespace motioncontrol
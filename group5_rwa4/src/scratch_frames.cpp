@@ -0,0 +1,150 @@
+#include "../include/util/scratch_frames.h"
+#include "../include/util/transform_service.h"
+#include "../include/util/sim_clock.h"
+#include <cmath>
+#include <std_msgs/UInt32.h>
+
+namespace {
+    // the buffer stores what was sent, only rounding can differ
+    constexpr double kMatchTolerance = 1e-6;
+
+    bool sameTransform(const geometry_msgs::Transform& a, const geometry_msgs::Transform& b)
+    {
+        return std::fabs(a.translation.x - b.translation.x) < kMatchTolerance &&
+            std::fabs(a.translation.y - b.translation.y) < kMatchTolerance &&
+            std::fabs(a.translation.z - b.translation.z) < kMatchTolerance &&
+            std::fabs(a.rotation.x - b.rotation.x) < kMatchTolerance &&
+            std::fabs(a.rotation.y - b.rotation.y) < kMatchTolerance &&
+            std::fabs(a.rotation.z - b.rotation.z) < kMatchTolerance &&
+            std::fabs(a.rotation.w - b.rotation.w) < kMatchTolerance;
+    }
+
+    std::string frameName(std::size_t slot)
+    {
+        return "group5_scratch_" + std::to_string(slot) + "_frame";
+    }
+}
+
+namespace motioncontrol {
+
+    constexpr std::size_t ScratchFrames::kPoolSize;
+
+    ScratchFrames& ScratchFrames::instance()
+    {
+        static ScratchFrames frames;
+        return frames;
+    }
+
+    void ScratchFrames::advertise(ros::NodeHandle& node, const std::string& topic)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            live_frames_pub_ = node.advertise<std_msgs::UInt32>(topic, 1, true);
+        }
+        publishLiveFrames();
+    }
+
+    std::size_t ScratchFrames::liveFrames() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return live_frames_;
+    }
+
+    bool ScratchFrames::acquire(const ros::Time& deadline, std::size_t& slot)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const bool free = SimClock::instance().waitUntil(available_, lock, deadline, [this, &slot] {
+            for (std::size_t i = 0; i < kPoolSize; i++) {
+                if (!in_use_[i]) {
+                    slot = i;
+                    return true;
+                }
+            }
+            return false;
+        });
+        if (free)
+            in_use_[slot] = true;
+        return free;
+    }
+
+    void ScratchFrames::release(std::size_t slot)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            in_use_[slot] = false;
+        }
+        available_.notify_one();
+    }
+
+    void ScratchFrames::publishLiveFrames()
+    {
+        std_msgs::UInt32 msg;
+        ros::Publisher pub;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            msg.data = static_cast<uint32_t>(live_frames_);
+            pub = live_frames_pub_;
+        }
+        if (pub)
+            pub.publish(msg);
+    }
+
+    bool ScratchFrames::toWorld(const std::string& parent, const geometry_msgs::Pose& pose,
+        const ros::Time& deadline, geometry_msgs::Pose& world_pose)
+    {
+        std::size_t slot;
+        if (!acquire(deadline, slot)) {
+            ROS_WARN_STREAM("[ScratchFrames] no free frame to resolve a pose in " << parent);
+            return false;
+        }
+
+        geometry_msgs::TransformStamped sent;
+        sent.header.stamp = ros::Time::now();
+        sent.header.frame_id = parent;
+        sent.child_frame_id = frameName(slot);
+        sent.transform.translation.x = pose.position.x;
+        sent.transform.translation.y = pose.position.y;
+        sent.transform.translation.z = pose.position.z;
+        sent.transform.rotation = pose.orientation;
+        broadcaster_.sendTransform(sent);
+
+        bool first_use = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!broadcast_[slot]) {
+                broadcast_[slot] = true;
+                live_frames_++;
+                first_use = true;
+            }
+        }
+        if (first_use)
+            publishLiveFrames();
+
+        // A reused child keeps its previous transform in the buffer until the
+        // new /tf_static message arrives, so wait for the one sent above.
+        const TransformService& tf = TransformService::instance();
+        bool found = false;
+        geometry_msgs::TransformStamped current;
+        while (ros::ok() && tf.waitForTransform(parent, sent.child_frame_id, deadline, current)) {
+            if (sameTransform(current.transform, sent.transform)) {
+                geometry_msgs::TransformStamped world_tf;
+                found = tf.waitForTransform("world", sent.child_frame_id, deadline, world_tf);
+                if (found) {
+                    world_pose.position.x = world_tf.transform.translation.x;
+                    world_pose.position.y = world_tf.transform.translation.y;
+                    world_pose.position.z = world_tf.transform.translation.z;
+                    world_pose.orientation = world_tf.transform.rotation;
+                }
+                break;
+            }
+            if (ros::Time::now() >= deadline)
+                break;
+            ros::Duration(0.01).sleep();
+        }
+
+        release(slot);
+        if (!found)
+            ROS_WARN_STREAM("[ScratchFrames] no transform from " << parent << " to world before the deadline");
+        return found;
+    }
+}  // namespace motioncontrol
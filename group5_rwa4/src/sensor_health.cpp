@@ -0,0 +1,127 @@
+#include "../include/util/sensor_health.h"
+#include "../include/util/sim_clock.h"
+#include <algorithm>
+
+namespace {
+    // weight of the latest interval in the smoothed period
+    constexpr double kPeriodSmoothing = 0.2;
+}
+
+namespace motioncontrol {
+
+    constexpr double SensorHealth::kSilencePeriods;
+    constexpr double SensorHealth::kMinSilence;
+    constexpr double SensorHealth::kCheckPeriod;
+    constexpr std::size_t SensorHealth::kMaxEvents;
+
+    SensorHealth& SensorHealth::instance()
+    {
+        static SensorHealth health;
+        return health;
+    }
+
+    void SensorHealth::start(ros::NodeHandle& node)
+    {
+        timer_ = node.createTimer(ros::Duration(kCheckPeriod), &SensorHealth::check, this);
+    }
+
+    void SensorHealth::heartbeat(SensorId sensor)
+    {
+        const ros::Time now = ros::Time::now();
+        const std::size_t i = index(sensor);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!last_seen_[i].isZero()) {
+            const double interval = (now - last_seen_[i]).toSec();
+            // a gap that ends a silence is not a period, it would delay the detection of the next one
+            const bool gap = blackout_ || !alive_[i] || (period_[i] > 0 && interval > silenceLimit(i));
+            if (!gap)
+                period_[i] = period_[i] > 0 ? (1 - kPeriodSmoothing) * period_[i] + kPeriodSmoothing * interval : interval;
+        }
+        last_seen_[i] = now;
+        if (!alive_[i]) {
+            alive_[i] = true;
+            emit(HealthEvent::Type::kSensorUp, sensor, now);
+        }
+        if (blackout_) {
+            blackout_ = false;
+            ROS_WARN_STREAM("[SensorHealth] sensor blackout ended");
+            emit(HealthEvent::Type::kBlackoutEnded, sensor, now);
+            changed_.notify_all();
+        }
+    }
+
+    double SensorHealth::silenceLimit(std::size_t i) const
+    {
+        return std::max(kMinSilence, kSilencePeriods * period_[i]);
+    }
+
+    void SensorHealth::check(const ros::TimerEvent&)
+    {
+        const ros::Time now = ros::Time::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+        bool seen = false;
+        bool all_down = true;
+        for (std::size_t i = 0; i < kSensorCount; i++) {
+            if (last_seen_[i].isZero())
+                continue;
+            seen = true;
+            if (alive_[i] && (now - last_seen_[i]).toSec() > silenceLimit(i)) {
+                alive_[i] = false;
+                emit(HealthEvent::Type::kSensorDown, static_cast<SensorId>(i), now);
+            }
+            all_down = all_down && !alive_[i];
+        }
+        if (seen && all_down && !blackout_) {
+            blackout_ = true;
+            ROS_WARN_STREAM("[SensorHealth] sensor blackout started");
+            emit(HealthEvent::Type::kBlackoutStarted, SensorId::kCount, now);
+            changed_.notify_all();
+        }
+    }
+
+    void SensorHealth::emit(HealthEvent::Type type, SensorId sensor, const ros::Time& stamp)
+    {
+        if (events_.size() == kMaxEvents)
+            events_.pop_front();
+        events_.push_back(HealthEvent{ type, sensor, stamp });
+    }
+
+    bool SensorHealth::blackout() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return blackout_;
+    }
+
+    bool SensorHealth::alive(SensorId sensor) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return alive_[index(sensor)];
+    }
+
+    ros::Time SensorHealth::lastSeen(SensorId sensor) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return last_seen_[index(sensor)];
+    }
+
+    double SensorHealth::rate(SensorId sensor) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const double period = period_[index(sensor)];
+        return period > 0 ? 1.0 / period : 0.0;
+    }
+
+    bool SensorHealth::waitForSensors(const ros::Time& deadline) const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return SimClock::instance().waitUntil(changed_, lock, deadline, [this] { return !blackout_; });
+    }
+
+    std::vector<HealthEvent> SensorHealth::takeEvents()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<HealthEvent> events(events_.begin(), events_.end());
+        events_.clear();
+        return events;
+    }
+}  // namespace motioncontrol
@@ -0,0 +1,270 @@
+#include "../include/util/sensor_log.h"
+#include "../include/util/transform_service.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <boost/make_shared.hpp>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace motioncontrol {
+
+    namespace {
+        const ros::Duration kTransformTimeout(1.0);
+        const char* const kLaserProfilerTopic = "/ariac/laser_profiler_0";
+        const char* const kOrdersTopic = "/ariac/orders";
+        // by source: kitting arm, gantry
+        const char* const kGripperStateTopics[] = { "/ariac/kitting/arm/gripper/state", "/ariac/gantry/arm/gripper/state" };
+    }  // namespace
+
+    constexpr char SensorLogFormat::kMagic[8];
+    constexpr std::uint32_t SensorLogFormat::kVersion;
+    constexpr std::size_t SensorLogFormat::kFileHeaderSize;
+    constexpr std::size_t SensorLogFormat::kAlignment;
+
+    SensorRecorder& SensorRecorder::instance()
+    {
+        static SensorRecorder recorder;
+        return recorder;
+    }
+
+    SensorRecorder::~SensorRecorder()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (file_)
+            std::fclose(file_);
+    }
+
+    bool SensorRecorder::start(ros::NodeHandle& node, const std::string& path)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (file_) {
+                ROS_WARN_STREAM("[SensorRecorder] already recording, " << path << " ignored");
+                return false;
+            }
+            file_ = std::fopen(path.c_str(), "wb");
+            if (!file_) {
+                ROS_WARN_STREAM("[SensorRecorder] cannot open " << path << ": " << std::strerror(errno));
+                return false;
+            }
+            char header[SensorLogFormat::kFileHeaderSize] = {};
+            std::memcpy(header, SensorLogFormat::kMagic, sizeof(SensorLogFormat::kMagic));
+            std::memcpy(header + sizeof(SensorLogFormat::kMagic), &SensorLogFormat::kVersion, sizeof(SensorLogFormat::kVersion));
+            std::fwrite(header, 1, sizeof(header), file_);
+            records_ = 0;
+            frames_.clear();
+        }
+
+        // sensor poses first, the replay needs them before the first image
+        for (const auto& sensor : Registry::sensors)
+            writeTransform(sensor.frame);
+
+        for (const auto& sensor : Registry::sensors) {
+            const SensorId id = sensor.id;
+            subscribers_.push_back(node.subscribe<nist_gear::LogicalCameraImage>(sensor.topic, 10,
+                [this, id](const nist_gear::LogicalCameraImage::ConstPtr& msg) {
+                    write(RecordKind::kLogicalCamera, static_cast<std::uint16_t>(index(id)), ros::Time::now(), *msg);
+                }));
+        }
+        subscribers_.push_back(node.subscribe<nist_gear::Proximity>(kBreakbeamTopic, 10,
+            [this](const nist_gear::Proximity::ConstPtr& msg) {
+                writeTransform(msg->header.frame_id);
+                write(RecordKind::kBreakbeam, 0, ros::Time::now(), *msg);
+            }));
+        subscribers_.push_back(node.subscribe<sensor_msgs::LaserScan>(kLaserProfilerTopic, 10,
+            [this](const sensor_msgs::LaserScan::ConstPtr& msg) {
+                write(RecordKind::kLaserScan, 0, ros::Time::now(), *msg);
+            }));
+        subscribers_.push_back(node.subscribe<nist_gear::Order>(kOrdersTopic, 10,
+            [this](const nist_gear::Order::ConstPtr& msg) {
+                write(RecordKind::kOrder, 0, ros::Time::now(), *msg);
+            }));
+        for (std::uint16_t arm = 0; arm < 2; arm++) {
+            subscribers_.push_back(node.subscribe<nist_gear::VacuumGripperState>(kGripperStateTopics[arm], 10,
+                [this, arm](const nist_gear::VacuumGripperState::ConstPtr& msg) {
+                    write(RecordKind::kGripperState, arm, ros::Time::now(), *msg);
+                }));
+        }
+        ROS_INFO_STREAM("[SensorRecorder] recording to " << path);
+        return true;
+    }
+
+    void SensorRecorder::stop()
+    {
+        for (auto& subscriber : subscribers_)
+            subscriber.shutdown();
+        subscribers_.clear();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!file_)
+            return;
+        std::fclose(file_);
+        file_ = nullptr;
+        ROS_INFO_STREAM("[SensorRecorder] " << records_ << " records written");
+    }
+
+    std::uint64_t SensorRecorder::records() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return records_;
+    }
+
+    void SensorRecorder::append(RecordKind kind, std::uint16_t source, const ros::Time& stamp, std::uint32_t size)
+    {
+        SensorLogFormat::RecordHeader header{ size, static_cast<std::uint16_t>(kind), source, stamp.sec, stamp.nsec };
+        std::fwrite(&header, sizeof(header), 1, file_);
+        std::fwrite(buffer_.data(), 1, buffer_.size(), file_);
+        records_++;
+    }
+
+    void SensorRecorder::writeTransform(const std::string& frame)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (frame.empty() || !frames_.insert(frame).second)
+                return;
+        }
+        geometry_msgs::TransformStamped world_frame_tf;
+        if (!TransformService::instance().lookup("world", frame, kTransformTimeout, world_frame_tf)) {
+            ROS_WARN_STREAM("[SensorRecorder] no pose for " << frame << ", a replay will miss it");
+            return;
+        }
+        write(RecordKind::kTransform, 0, ros::Time::now(), world_frame_tf);
+    }
+
+    SensorLog::~SensorLog()
+    {
+        close();
+    }
+
+    void SensorLog::close()
+    {
+        if (map_)
+            munmap(map_, length_);
+        map_ = nullptr;
+        length_ = 0;
+        records_.clear();
+    }
+
+    bool SensorLog::open(const std::string& path)
+    {
+        close();
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            ROS_WARN_STREAM("[SensorLog] cannot open " << path << ": " << std::strerror(errno));
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < SensorLogFormat::kFileHeaderSize) {
+            ROS_WARN_STREAM("[SensorLog] " << path << " is not a sensor log");
+            ::close(fd);
+            return false;
+        }
+        length_ = static_cast<std::size_t>(info.st_size);
+        map_ = mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (map_ == MAP_FAILED) {
+            ROS_WARN_STREAM("[SensorLog] cannot map " << path << ": " << std::strerror(errno));
+            map_ = nullptr;
+            length_ = 0;
+            return false;
+        }
+
+        const auto* bytes = static_cast<const std::uint8_t*>(map_);
+        std::uint32_t version = 0;
+        std::memcpy(&version, bytes + sizeof(SensorLogFormat::kMagic), sizeof(version));
+        if (std::memcmp(bytes, SensorLogFormat::kMagic, sizeof(SensorLogFormat::kMagic)) != 0 ||
+            version != SensorLogFormat::kVersion) {
+            ROS_WARN_STREAM("[SensorLog] " << path << " is not a sensor log of version " << SensorLogFormat::kVersion);
+            close();
+            return false;
+        }
+
+        std::size_t offset = SensorLogFormat::kFileHeaderSize;
+        while (offset + sizeof(SensorLogFormat::RecordHeader) <= length_) {
+            SensorLogFormat::RecordHeader header;
+            std::memcpy(&header, bytes + offset, sizeof(header));
+            const std::size_t data = offset + sizeof(header);
+            if (header.kind >= kRecordKindCount || data + header.size > length_) {
+                ROS_WARN_STREAM("[SensorLog] " << path << " ends with a truncated record, " << records_.size() << " records kept");
+                break;
+            }
+            records_.push_back(Record{ static_cast<RecordKind>(header.kind), header.source,
+                ros::Time(header.sec, header.nsec), bytes + data, header.size });
+            offset = data + SensorLogFormat::padded(header.size);
+        }
+        return true;
+    }
+
+    SensorReplayer::Stats SensorReplayer::replay(const SensorLog& log, double speed, const Handlers& handlers)
+    {
+        Stats stats;
+        const auto& records = log.records();
+        if (records.empty())
+            return stats;
+
+        const ros::Time first = records.front().stamp;
+        const auto wall_start = std::chrono::steady_clock::now();
+        for (const auto& record : records) {
+            if (speed > 0) {
+                const double offset = (record.stamp - first).toSec() / speed;
+                std::this_thread::sleep_until(wall_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(offset)));
+            }
+            ros::Time::setNow(record.stamp);
+            stats.records[static_cast<std::size_t>(record.kind)]++;
+
+            switch (record.kind) {
+                case RecordKind::kTransform: {
+                    geometry_msgs::TransformStamped transform;
+                    record.read(transform);
+                    TransformService::instance().buffer().setTransform(transform, "sensor_replay", true);
+                    break;
+                }
+                case RecordKind::kLogicalCamera:
+                    if (handlers.logical_camera && record.source < kSensorCount) {
+                        auto msg = boost::make_shared<nist_gear::LogicalCameraImage>();
+                        record.read(*msg);
+                        handlers.logical_camera(static_cast<SensorId>(record.source), msg);
+                    }
+                    break;
+                case RecordKind::kBreakbeam:
+                    if (handlers.breakbeam) {
+                        auto msg = boost::make_shared<nist_gear::Proximity>();
+                        record.read(*msg);
+                        handlers.breakbeam(msg);
+                    }
+                    break;
+                case RecordKind::kLaserScan:
+                    if (handlers.laser_scan) {
+                        auto msg = boost::make_shared<sensor_msgs::LaserScan>();
+                        record.read(*msg);
+                        handlers.laser_scan(msg);
+                    }
+                    break;
+                case RecordKind::kOrder:
+                    if (handlers.order) {
+                        auto msg = boost::make_shared<nist_gear::Order>();
+                        record.read(*msg);
+                        handlers.order(msg);
+                    }
+                    break;
+                case RecordKind::kGripperState:
+                    if (handlers.gripper_state) {
+                        auto msg = boost::make_shared<nist_gear::VacuumGripperState>();
+                        record.read(*msg);
+                        handlers.gripper_state(record.source, msg);
+                    }
+                    break;
+                case RecordKind::kCount:
+                    break;
+            }
+        }
+        stats.log_seconds = (records.back().stamp - first).toSec();
+        stats.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+        return stats;
+    }
+}  // namespace motioncontrol
@@ -0,0 +1,66 @@
+#include "../include/util/sim_clock.h"
+
+namespace motioncontrol {
+
+    constexpr double SimClock::kTickedSlice;
+    constexpr double SimClock::kPolledSlice;
+
+    SimClock& SimClock::instance()
+    {
+        static SimClock clock;
+        return clock;
+    }
+
+    void SimClock::tick(const ros::Time& stamp)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stamp > last_tick_)
+            last_tick_ = stamp;
+        last_tick_wall_ = std::chrono::steady_clock::now();
+        // the woken waits remove themselves
+        for (auto waiter = waiters_.begin(); waiter != waiters_.end() && waiter->first <= last_tick_; ++waiter)
+            waiter->second->notify_all();
+    }
+
+    ros::Time SimClock::now() const
+    {
+        const ros::Time ros_now = ros::Time::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+        return ros_now > last_tick_ ? ros_now : last_tick_;
+    }
+
+    bool SimClock::sleepUntil(const ros::Time& deadline)
+    {
+        std::mutex mutex;
+        std::condition_variable woken;
+        std::unique_lock<std::mutex> lock(mutex);
+        waitUntil(woken, lock, deadline, [] { return false; });
+        return now() >= deadline;
+    }
+
+    bool SimClock::sleepFor(const ros::Duration& duration)
+    {
+        return sleepUntil(now() + duration);
+    }
+
+    SimClock::Waiters::iterator SimClock::enlist(const ros::Time& deadline, std::condition_variable& cv)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return waiters_.emplace(deadline, &cv);
+    }
+
+    void SimClock::delist(Waiters::iterator waiter)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        waiters_.erase(waiter);
+    }
+
+    std::chrono::milliseconds SimClock::slice() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // ticks stopped, or never came: fall back to checking often
+        const bool ticking = !last_tick_.isZero() &&
+            std::chrono::steady_clock::now() - last_tick_wall_ < std::chrono::duration<double>(kTickedSlice);
+        return std::chrono::milliseconds(static_cast<long>(1000 * (ticking ? kTickedSlice : kPolledSlice)));
+    }
+}  // namespace motioncontrol
@@ -0,0 +1,73 @@
+#include "../include/util/transform_service.h"
+
+namespace motioncontrol {
+
+    TransformService::TransformService() : buffer_()
+    {
+        // subscribing without a master would block until one comes up
+        if (ros::master::check())
+            listener_.reset(new tf2_ros::TransformListener(buffer_));
+        else
+            ROS_WARN_STREAM("[TransformService] no ROS master, transforms come from the buffer only");
+    }
+
+    TransformService& TransformService::instance()
+    {
+        static TransformService service;
+        return service;
+    }
+
+    bool TransformService::warmup(const std::vector<std::string>& frames, const ros::Duration& timeout)
+    {
+        const ros::Time deadline = ros::Time::now() + timeout;
+        bool all_found = true;
+        for (const auto& frame : frames) {
+            geometry_msgs::TransformStamped transform;
+            if (!waitForTransform("world", frame, deadline, transform))
+                all_found = false;
+        }
+        return all_found;
+    }
+
+    bool TransformService::waitForTransform(const std::string& target, const std::string& source,
+        const ros::Time& deadline, geometry_msgs::TransformStamped& transform, ros::Duration* waited) const
+    {
+        const ros::Time start = ros::Time::now();
+        ros::Duration remaining = deadline - start;
+        if (remaining < ros::Duration(0.0))
+            remaining = ros::Duration(0.0);
+
+        std::string error;
+        bool found = buffer_.canTransform(target, source, ros::Time(0), remaining, &error);
+        if (found) {
+            try {
+                transform = buffer_.lookupTransform(target, source, ros::Time(0));
+            }
+            catch (tf2::TransformException& ex) {
+                error = ex.what();
+                found = false;
+            }
+        }
+
+        const ros::Duration elapsed = ros::Time::now() - start;
+        if (waited)
+            *waited = elapsed;
+        if (found)
+            ROS_DEBUG_STREAM("[TransformService] " << source << " -> " << target << " after " << elapsed.toSec() << " s");
+        else
+            ROS_WARN_STREAM("[TransformService] " << source << " -> " << target << " not available after "
+                << elapsed.toSec() << " s: " << error);
+        return found;
+    }
+
+    bool TransformService::lookup(const std::string& target, const std::string& source,
+        const ros::Duration& timeout, geometry_msgs::TransformStamped& transform) const
+    {
+        return waitForTransform(target, source, ros::Time::now() + timeout, transform);
+    }
+
+    tf2_ros::Buffer& TransformService::buffer()
+    {
+        return buffer_;
+    }
+}  // namespace motioncontrol
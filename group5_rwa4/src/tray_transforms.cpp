@@ -0,0 +1,96 @@
+#include "../include/util/tray_transforms.h"
+#include "../include/util/transform_service.h"
+#include "../include/util/sim_clock.h"
+#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+
+namespace motioncontrol {
+
+    TrayTransforms& TrayTransforms::instance()
+    {
+        static TrayTransforms transforms;
+        return transforms;
+    }
+
+    bool TrayTransforms::trayInWorld(TrayId tray, const ros::Time& deadline, tf2::Transform& tray_in_world)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (cached_[index(tray)]) {
+                tray_in_world = trays_[index(tray)];
+                return true;
+            }
+        }
+
+        geometry_msgs::TransformStamped world_tray_tf;
+        if (!TransformService::instance().waitForTransform("world", trayInfo(tray).frame, deadline, world_tray_tf))
+            return false;
+        tf2::fromMsg(world_tray_tf.transform, tray_in_world);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!in_transit_[index(tray)]) {
+            trays_[index(tray)] = tray_in_world;
+            cached_[index(tray)] = true;
+        }
+        return true;
+    }
+
+    bool TrayTransforms::toWorld(TrayId tray, const geometry_msgs::Pose& pose_in_tray,
+        const ros::Time& deadline, geometry_msgs::Pose& world_pose)
+    {
+        tf2::Transform tray_in_world;
+        if (!trayInWorld(tray, deadline, tray_in_world))
+            return false;
+        tf2::Transform pose_transform;
+        tf2::fromMsg(pose_in_tray, pose_transform);
+        tf2::toMsg(tray_in_world * pose_transform, world_pose);
+        return true;
+    }
+
+    bool TrayTransforms::placementTargets(std::vector<Product>& products, const std::string& location,
+        const ros::Time& deadline)
+    {
+        TrayId tray;
+        if (!trayFromLocation(location, tray)) {
+            ROS_WARN_STREAM("[TrayTransforms] unknown location " << location);
+            return false;
+        }
+        tf2::Transform tray_in_world;
+        if (!trayInWorld(tray, deadline, tray_in_world))
+            return false;
+        for (auto& product : products) {
+            tf2::Transform pose_transform;
+            tf2::fromMsg(product.frame_pose, pose_transform);
+            tf2::toMsg(tray_in_world * pose_transform, product.target_pose);
+        }
+        return true;
+    }
+
+    void TrayTransforms::stationChanged(TrayId agv, const std::string& station)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& current = stations_[index(agv)];
+        if (current == station)
+            return;
+        if (!current.empty())
+            ROS_INFO_STREAM("[TrayTransforms] " << trayInfo(agv).location << " moved from " << current << " to " << station);
+        current = station;
+        in_transit_[index(agv)] = false;
+        cached_[index(agv)] = false;
+        station_changed_.notify_all();
+    }
+
+    void TrayTransforms::agvShipped(TrayId agv)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_transit_[index(agv)] = true;
+        cached_[index(agv)] = false;
+    }
+
+    bool TrayTransforms::waitForStation(TrayId agv, const std::string& station, const ros::Time& deadline)
+    {
+        const std::size_t i = index(agv);
+        std::unique_lock<std::mutex> lock(mutex_);
+        return SimClock::instance().waitUntil(station_changed_, lock, deadline,
+            [this, i, &station] { return !in_transit_[i] && stations_[i] == station; });
+    }
+}  // namespace motioncontrol
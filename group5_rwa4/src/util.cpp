@@ -1,5 +1,8 @@
 #include "../include/util/util.h"
-#include <stdlib.h>
+#include "../include/util/transform_service.h"
+#include "../include/util/workcell_transforms.h"
+#include "../include/util/scratch_frames.h"
+#include "../include/util/tray_transforms.h"
 
 namespace motioncontrol {
 
@@ -82,27 +85,8 @@ namespace motioncontrol {
     }
 
     geometry_msgs::Pose transformToWorldFrame(std::string part_in_camera_frame) {
-        tf2_ros::Buffer tfBuffer;
-        tf2_ros::TransformListener tfListener(tfBuffer);
-        ros::Rate rate(10);
-        ros::Duration timeout(1.0);
-
-
         geometry_msgs::TransformStamped world_target_tf;
-        geometry_msgs::TransformStamped ee_target_tf;
-
-
-        for (int i = 0; i < 10; i++) {
-            try {
-                world_target_tf = tfBuffer.lookupTransform("world", part_in_camera_frame,
-                    ros::Time(0), timeout);
-            }
-            catch (tf2::TransformException& ex) {
-                ROS_WARN("%s", ex.what());
-                ros::Duration(1.0).sleep();
-                continue;
-            }
-        }
+        TransformService::instance().lookup("world", part_in_camera_frame, kTransformTimeout, world_target_tf);
 
         geometry_msgs::Pose world_target{};
         world_target.position.x = world_target_tf.transform.translation.x;
@@ -117,215 +101,53 @@ namespace motioncontrol {
     }
     
 
+    bool transformtoWorldFrame(
+        const geometry_msgs::Pose& target,
+        std::string location,
+        const ros::Time& deadline,
+        geometry_msgs::Pose& world_pose) {
+        TrayId tray;
+        if (!trayFromLocation(location, tray)) {
+            ROS_WARN_STREAM("[transformtoWorldFrame] unknown location " << location);
+            return false;
+        }
+        // kit tray and briefcase poses are cached until the AGV moves
+        return TrayTransforms::instance().toWorld(tray, target, deadline, world_pose);
+    }
+
     geometry_msgs::Pose transformtoWorldFrame(
         const geometry_msgs::Pose& target,
         std::string location) {
-        static tf2_ros::StaticTransformBroadcaster br;
-        geometry_msgs::TransformStamped transformStamped;
-
-        std::string kit_tray;
-        if (location.compare("agv1") == 0)
-            kit_tray = "kit_tray_1";
-        else if (location.compare("agv2") == 0)
-            kit_tray = "kit_tray_2";
-        else if (location.compare("agv3") == 0)
-            kit_tray = "kit_tray_3";
-        else if (location.compare("agv4") == 0)
-            kit_tray = "kit_tray_4";
-        else if (location.compare("as1") == 0)
-            kit_tray = "briefcase_1";
-        else if (location.compare("as2") == 0)
-            kit_tray = "briefcase_2";
-        else if (location.compare("as3") == 0)
-            kit_tray = "briefcase_3";
-        else if (location.compare("as4") == 0)
-            kit_tray = "briefcase_4";
-
-        transformStamped.header.stamp = ros::Time::now();
-        transformStamped.header.frame_id = kit_tray;
-        transformStamped.child_frame_id = "target_frame";
-        transformStamped.transform.translation.x = target.position.x;
-        transformStamped.transform.translation.y = target.position.y;
-        transformStamped.transform.translation.z = target.position.z;
-        transformStamped.transform.rotation.x = target.orientation.x;
-        transformStamped.transform.rotation.y = target.orientation.y;
-        transformStamped.transform.rotation.z = target.orientation.z;
-        transformStamped.transform.rotation.w = target.orientation.w;
-      
-
-        for (int i{ 0 }; i < 5; ++i)
-            br.sendTransform(transformStamped);
-        tf2_ros::Buffer tfBuffer;
-        tf2_ros::TransformListener tfListener(tfBuffer);
-        ros::Rate rate(10);
-        ros::Duration timeout(1.0);
-
-        geometry_msgs::TransformStamped world_pose_tf;
-        geometry_msgs::TransformStamped ee_target_tf;
-
-
-        for (int i = 0; i < 10; i++) {
-            try {
-                world_pose_tf = tfBuffer.lookupTransform("world", "target_frame",
-                    ros::Time(0), timeout);
-            }
-            catch (tf2::TransformException& ex) {
-                ROS_WARN("%s", ex.what());
-                ros::Duration(1.0).sleep();
-                continue;
-            }
-        }
         geometry_msgs::Pose world_pose{};
-        world_pose.position.x = world_pose_tf.transform.translation.x;
-        world_pose.position.y = world_pose_tf.transform.translation.y;
-        world_pose.position.z = world_pose_tf.transform.translation.z;
-        world_pose.orientation.x = world_pose_tf.transform.rotation.x;
-        world_pose.orientation.y = world_pose_tf.transform.rotation.y;
-        world_pose.orientation.z = world_pose_tf.transform.rotation.z;
-        world_pose.orientation.w = world_pose_tf.transform.rotation.w;
-
+        transformtoWorldFrame(target, location, ros::Time::now() + kTransformTimeout, world_pose);
         return world_pose;
     }
 
+    bool gettransforminWorldFrame(
+        const geometry_msgs::Pose& target,
+        std::string frame,
+        const ros::Time& deadline,
+        geometry_msgs::Pose& world_pose) {
+        // kit tray poses are cached until the AGV moves
+        TrayId tray;
+        if (trayFromLocation(frame, tray))
+            return TrayTransforms::instance().toWorld(tray, target, deadline, world_pose);
+
+        // Sensors are fixed in the workcell, so their poses are converted
+        // in-process
+        SensorId sensor;
+        if (!sensorFromName(frame, sensor))
+            return ScratchFrames::instance().toWorld(frame + "_frame", target, deadline, world_pose);
+        if (WorkcellTransforms::instance().toWorld(sensor, target, world_pose))
+            return true;
+        return ScratchFrames::instance().toWorld(sensorInfo(sensor).frame, target, deadline, world_pose);
+    }
+
     geometry_msgs::Pose gettransforminWorldFrame(
         const geometry_msgs::Pose& target,
         std::string frame) {
-        static tf2_ros::StaticTransformBroadcaster br;
-        geometry_msgs::TransformStamped transformStamped;
-
-        std::string header;
-        std::string child;
-        std::string child_frame;
-        child = "target_";
-
-        if (frame.compare("agv1") == 0)
-            header = "kit_tray_1";
-        else if (frame.compare("agv2") == 0)
-            header = "kit_tray_2";
-        else if (frame.compare("agv3") == 0)
-            header = "kit_tray_3";
-        else if (frame.compare("agv4") == 0)
-            header = "kit_tray_4";
-        else if (frame.compare("quality_control_sensor_1") == 0){
-            header = "quality_control_sensor_1_frame";
-            child = "quality_control_sensor_1_model_";
-        }
-        else if (frame.compare("quality_control_sensor_2") == 0){
-            header = "quality_control_sensor_2_frame";
-            child = "quality_control_sensor_2_model_";
-        }
-        else if (frame.compare("quality_control_sensor_3") == 0){
-            header = "quality_control_sensor_3_frame";
-            child = "quality_control_sensor_3_model_";
-        }
-        else if (frame.compare("quality_control_sensor_4") == 0){
-            header = "quality_control_sensor_4_frame";
-            child = "quality_control_sensor_4_model_";
-        }
-        else if (frame.compare("logical_camera_bins0") == 0){
-            header = "logical_camera_bins0_frame";
-            child = "logical_camera_bins0_model_";
-        }
-        else if (frame.compare("logical_camera_bins1") == 0){
-            header = "logical_camera_bins1_frame";
-            child = "logical_camera_bins1_model_";
-        }
-        else if (frame.compare("logical_camera_agv1as1") == 0){
-            header = "logical_camera_agv1as1_frame";
-            child = "logical_camera_agv1as1_model_";
-        }
-        else if (frame.compare("logical_camera_agv1as2") == 0){
-            header = "logical_camera_agv1as2_frame";
-            child = "logical_camera_agv1as2_model_";
-        }
-        else if (frame.compare("logical_camera_agv2as1") == 0){
-            header = "logical_camera_agv2as1_frame";
-            child = "logical_camera_agv2as1_model_";
-        }
-        else if (frame.compare("logical_camera_agv2as2") == 0){
-            header = "logical_camera_agv2as2_frame";
-            child = "logical_camera_agv2as2_model_";
-        }
-        else if (frame.compare("logical_camera_agv3as3") == 0){
-            header = "logical_camera_agv3as3_frame";
-            child = "logical_camera_agv3as3_model_";
-        }
-        else if (frame.compare("logical_camera_agv3as4") == 0){
-            header = "logical_camera_agv3as4_frame";
-            child = "logical_camera_agv3as4_model_";
-        }
-        else if (frame.compare("logical_camera_agv4as3") == 0){
-            header = "logical_camera_agv4as3_frame";
-            child = "logical_camera_agv4as3_model_";
-        }
-        else if (frame.compare("logical_camera_agv4as4") == 0){
-            header = "logical_camera_agv4as4_frame";
-            child = "logical_camera_agv4as4_model_";
-        }
-        else if (frame.compare("logical_camera_station1") == 0){
-            header = "logical_camera_station1_frame";
-            child = "logical_camera_station1_model_";
-        }
-        else if (frame.compare("logical_camera_station2") == 0){
-            header = "logical_camera_station2_frame";
-            child = "logical_camera_station2_model_";
-        }
-        else if (frame.compare("logical_camera_station3") == 0){
-            header = "logical_camera_station3_frame";
-            child = "logical_camera_station3_model_";
-        }
-        else if (frame.compare("logical_camera_station4") == 0){
-            header = "logical_camera_station4_frame";
-            child = "logical_camera_station4_model_";
-        }
-        
-
-        child_frame = child + std::to_string(rand()) + "_frame";
-
-
-        transformStamped.header.stamp = ros::Time::now();
-        transformStamped.header.frame_id = header;
-        transformStamped.child_frame_id = child_frame;
-        transformStamped.transform.translation.x = target.position.x;
-        transformStamped.transform.translation.y = target.position.y;
-        transformStamped.transform.translation.z = target.position.z;
-        transformStamped.transform.rotation.x = target.orientation.x;
-        transformStamped.transform.rotation.y = target.orientation.y;
-        transformStamped.transform.rotation.z = target.orientation.z;
-        transformStamped.transform.rotation.w = target.orientation.w;
-      
-
-        for (int i{ 0 }; i < 5; ++i)
-            br.sendTransform(transformStamped);
-        tf2_ros::Buffer tfBuffer;
-        tf2_ros::TransformListener tfListener(tfBuffer);
-        ros::Rate rate(10);
-        ros::Duration timeout(1.0);
-
-        geometry_msgs::TransformStamped world_pose_tf;
-        geometry_msgs::TransformStamped ee_target_tf;
-
-
-        for (int i = 0; i < 10; i++) {
-            try {
-                world_pose_tf = tfBuffer.lookupTransform("world", child_frame,
-                    ros::Time(0), timeout);
-            }
-            catch (tf2::TransformException& ex) {
-                ROS_WARN("%s", ex.what());
-                ros::Duration(1.0).sleep();
-                continue;
-            }
-        }
         geometry_msgs::Pose world_pose{};
-        world_pose.position.x = world_pose_tf.transform.translation.x;
-        world_pose.position.y = world_pose_tf.transform.translation.y;
-        world_pose.position.z = world_pose_tf.transform.translation.z;
-        world_pose.orientation.x = world_pose_tf.transform.rotation.x;
-        world_pose.orientation.y = world_pose_tf.transform.rotation.y;
-        world_pose.orientation.z = world_pose_tf.transform.rotation.z;
-        world_pose.orientation.w = world_pose_tf.transform.rotation.w;
-
+        gettransforminWorldFrame(target, frame, ros::Time::now() + kTransformTimeout, world_pose);
         return world_pose;
     }
 
@@ -0,0 +1,123 @@
+#include "../include/util/workcell_transforms.h"
+#include "../include/util/transform_service.h"
+#include "../include/util/util.h"
+#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+
+namespace {
+    // YAML numbers without a decimal point come back as ints
+    double toDouble(XmlRpc::XmlRpcValue& value)
+    {
+        if (value.getType() == XmlRpc::XmlRpcValue::TypeInt)
+            return static_cast<int>(value);
+        return static_cast<double>(value);
+    }
+
+    bool readTriple(XmlRpc::XmlRpcValue& value, double (&out)[3])
+    {
+        if (value.getType() != XmlRpc::XmlRpcValue::TypeArray || value.size() != 3)
+            return false;
+        for (int i = 0; i < 3; i++) {
+            if (value[i].getType() != XmlRpc::XmlRpcValue::TypeDouble &&
+                value[i].getType() != XmlRpc::XmlRpcValue::TypeInt)
+                return false;
+            out[i] = toDouble(value[i]);
+        }
+        return true;
+    }
+}
+
+namespace motioncontrol {
+
+    WorkcellTransforms& WorkcellTransforms::instance()
+    {
+        static WorkcellTransforms transforms;
+        return transforms;
+    }
+
+    bool WorkcellTransforms::load(const ros::NodeHandle& node, const std::string& param)
+    {
+        XmlRpc::XmlRpcValue sensors;
+        if (!node.getParam(param, sensors) || sensors.getType() != XmlRpc::XmlRpcValue::TypeStruct) {
+            ROS_WARN_STREAM("[WorkcellTransforms] " << param << " not found, sensor poses will come from TF");
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::size_t loaded = 0;
+        for (auto& sensor : sensors) {
+            SensorId id;
+            if (!sensorFromName(sensor.first, id) || !sensor.second.hasMember("pose"))
+                continue;
+            auto& pose = sensor.second["pose"];
+            double xyz[3], rpy[3];
+            if (!pose.hasMember("xyz") || !pose.hasMember("rpy") ||
+                !readTriple(pose["xyz"], xyz) || !readTriple(pose["rpy"], rpy)) {
+                ROS_WARN_STREAM("[WorkcellTransforms] malformed pose for " << sensor.first);
+                continue;
+            }
+            tf2::Quaternion q;
+            q.setRPY(rpy[0], rpy[1], rpy[2]);
+            sensors_[index(id)] = tf2::Transform(q, tf2::Vector3(xyz[0], xyz[1], xyz[2]));
+            known_[index(id)] = true;
+            loaded++;
+        }
+        ROS_INFO_STREAM("[WorkcellTransforms] loaded " << loaded << " sensor poses");
+        return loaded > 0;
+    }
+
+    bool WorkcellTransforms::sensorInWorld(SensorId sensor, tf2::Transform& sensor_in_world)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (known_[index(sensor)]) {
+                sensor_in_world = sensors_[index(sensor)];
+                return true;
+            }
+        }
+
+        // Not in the config, the sensor frame is static so one lookup is enough
+        geometry_msgs::TransformStamped world_sensor_tf;
+        if (!TransformService::instance().lookup("world", sensorInfo(sensor).frame, ros::Duration(1.0), world_sensor_tf))
+            return false;
+        tf2::fromMsg(world_sensor_tf.transform, sensor_in_world);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        sensors_[index(sensor)] = sensor_in_world;
+        known_[index(sensor)] = true;
+        return true;
+    }
+
+    bool WorkcellTransforms::toWorld(SensorId sensor, const geometry_msgs::Pose& pose_in_sensor,
+        geometry_msgs::Pose& world_pose)
+    {
+        tf2::Transform sensor_in_world;
+        if (!sensorInWorld(sensor, sensor_in_world))
+            return false;
+        tf2::Transform pose_transform;
+        tf2::fromMsg(pose_in_sensor, pose_transform);
+        tf2::toMsg(sensor_in_world * pose_transform, world_pose);
+        return true;
+    }
+
+    bool transformImageToWorld(const nist_gear::LogicalCameraImage& image, SensorId sensor,
+        std::vector<geometry_msgs::Pose>& world_poses)
+    {
+        world_poses.resize(image.models.size());
+        if (image.models.empty())
+            return true;
+
+        // a per-model lookup would wait on the same missing frame, once per model
+        tf2::Transform sensor_in_world;
+        if (!WorkcellTransforms::instance().sensorInWorld(sensor, sensor_in_world)) {
+            ROS_WARN_STREAM_THROTTLE(5, "[WorkcellTransforms] no pose for " << sensorInfo(sensor).name << ", dropping its images");
+            return false;
+        }
+
+        tf2::Transform pose_transform;
+        for (std::size_t i = 0; i < image.models.size(); i++) {
+            tf2::fromMsg(image.models[i].pose, pose_transform);
+            tf2::toMsg(sensor_in_world * pose_transform, world_poses[i]);
+        }
+        return true;
+    }
+}  // namespace motioncontrol